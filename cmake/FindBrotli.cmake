@@ -0,0 +1,78 @@
+#
+# This file is open source software, licensed to you under the terms
+# of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+# distributed with this work for additional information regarding copyright
+# ownership.  You may not use this file except in compliance with the License.
+#
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+# - Find Brotli (the generic-purpose lossless compression library)
+#
+# This module defines
+#  Brotli_INCLUDE_DIR, where to find brotli/encode.h and brotli/decode.h
+#  Brotli_ENC_LIBRARY, Brotli_DEC_LIBRARY, Brotli_COMMON_LIBRARY, the brotli libraries
+#  Brotli_FOUND, If false, do not try to use brotli
+#  Brotli::brotlienc, Brotli::brotlidec, Brotli::brotlicommon, the imported targets
+
+find_package(PkgConfig QUIET)
+if(PkgConfig_FOUND)
+  pkg_check_modules(PC_Brotli_ENC QUIET libbrotlienc)
+  pkg_check_modules(PC_Brotli_DEC QUIET libbrotlidec)
+endif()
+
+find_library(Brotli_ENC_LIBRARY
+             NAMES brotlienc
+             HINTS ${PC_Brotli_ENC_LIBDIR} ${PC_Brotli_ENC_LIBRARY_DIRS})
+
+find_library(Brotli_DEC_LIBRARY
+             NAMES brotlidec
+             HINTS ${PC_Brotli_DEC_LIBDIR} ${PC_Brotli_DEC_LIBRARY_DIRS})
+
+find_library(Brotli_COMMON_LIBRARY
+             NAMES brotlicommon
+             HINTS ${PC_Brotli_DEC_LIBDIR} ${PC_Brotli_DEC_LIBRARY_DIRS})
+
+find_path(Brotli_INCLUDE_DIR
+          NAMES brotli/decode.h
+          HINTS ${PC_Brotli_DEC_INCLUDEDIR} ${PC_Brotli_DEC_INCLUDE_DIRS})
+
+mark_as_advanced(Brotli_ENC_LIBRARY Brotli_DEC_LIBRARY Brotli_COMMON_LIBRARY Brotli_INCLUDE_DIR)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Brotli
+                                  REQUIRED_VARS
+                                  Brotli_ENC_LIBRARY
+                                  Brotli_DEC_LIBRARY
+                                  Brotli_COMMON_LIBRARY
+                                  Brotli_INCLUDE_DIR
+                                  VERSION_VAR
+                                  PC_Brotli_DEC_VERSION)
+
+if(Brotli_FOUND AND NOT (TARGET Brotli::brotlicommon))
+  add_library(Brotli::brotlicommon UNKNOWN IMPORTED)
+  set_target_properties(Brotli::brotlicommon
+                        PROPERTIES IMPORTED_LOCATION "${Brotli_COMMON_LIBRARY}"
+                                   INTERFACE_INCLUDE_DIRECTORIES "${Brotli_INCLUDE_DIR}")
+
+  add_library(Brotli::brotlienc UNKNOWN IMPORTED)
+  set_target_properties(Brotli::brotlienc
+                        PROPERTIES IMPORTED_LOCATION "${Brotli_ENC_LIBRARY}"
+                                   INTERFACE_INCLUDE_DIRECTORIES "${Brotli_INCLUDE_DIR}"
+                                   INTERFACE_LINK_LIBRARIES Brotli::brotlicommon)
+
+  add_library(Brotli::brotlidec UNKNOWN IMPORTED)
+  set_target_properties(Brotli::brotlidec
+                        PROPERTIES IMPORTED_LOCATION "${Brotli_DEC_LIBRARY}"
+                                   INTERFACE_INCLUDE_DIRECTORIES "${Brotli_INCLUDE_DIR}"
+                                   INTERFACE_LINK_LIBRARIES Brotli::brotlicommon)
+endif()
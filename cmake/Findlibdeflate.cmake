@@ -0,0 +1,55 @@
+#
+# This file is open source software, licensed to you under the terms
+# of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+# distributed with this work for additional information regarding copyright
+# ownership.  You may not use this file except in compliance with the License.
+#
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+# - Find libdeflate (a fast, whole-buffer DEFLATE/zlib/gzip library)
+#
+# This module defines
+#  libdeflate_INCLUDE_DIR, where to find libdeflate.h
+#  libdeflate_LIBRARY, the libdeflate library
+#  libdeflate_FOUND, If false, do not try to use libdeflate
+#  libdeflate::libdeflate, the imported target
+
+find_package(PkgConfig QUIET)
+if(PkgConfig_FOUND)
+  pkg_check_modules(PC_libdeflate QUIET libdeflate)
+endif()
+
+find_library(libdeflate_LIBRARY
+             NAMES deflate
+             HINTS ${PC_libdeflate_LIBDIR} ${PC_libdeflate_LIBRARY_DIRS})
+
+find_path(libdeflate_INCLUDE_DIR
+          NAMES libdeflate.h
+          HINTS ${PC_libdeflate_INCLUDEDIR} ${PC_libdeflate_INCLUDE_DIRS})
+
+mark_as_advanced(libdeflate_LIBRARY libdeflate_INCLUDE_DIR)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(libdeflate
+                                  REQUIRED_VARS
+                                  libdeflate_LIBRARY
+                                  libdeflate_INCLUDE_DIR
+                                  VERSION_VAR
+                                  PC_libdeflate_VERSION)
+
+if(libdeflate_FOUND AND NOT (TARGET libdeflate::libdeflate))
+  add_library(libdeflate::libdeflate UNKNOWN IMPORTED)
+  set_target_properties(libdeflate::libdeflate
+                        PROPERTIES IMPORTED_LOCATION "${libdeflate_LIBRARY}"
+                                   INTERFACE_INCLUDE_DIRECTORIES "${libdeflate_INCLUDE_DIR}")
+endif()
@@ -0,0 +1,508 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+
+/* Export of decoded column batches through the Arrow C Data Interface:
+ * https://arrow.apache.org/docs/format/CDataInterface.html
+ *
+ * Leaf columns are exported one at a time, with their repeated ancestors as nested lists.
+ * Maps ("+m") and structs ("+s") would need all of their leaves exported together, which isn't supported:
+ * leaves nested in a map or a struct are rejected, rather than exported as plain lists of keys or values.
+ *
+ * Header-only, without a dependency on libarrow. Values which already have the Arrow layout
+ * (integers, floating point, dates, times, timestamps, INT96) are handed over without a copy:
+ * the exported ArrowArray takes ownership of the batch's vectors and frees them in its release callback.
+ * Other values (booleans, narrow integers, decimals, byte arrays) are converted once.
+ */
+
+#pragma once
+
+#include <parquet4seastar/columnar_reader.hh>
+#include <parquet4seastar/logical_type.hh>
+#include <parquet4seastar/overloaded.hh>
+#include <parquet4seastar/reader_schema.hh>
+#include <parquet4seastar/y_combinator.hh>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema
+{
+    // Array type description
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+struct ArrowArray
+{
+    // Array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+}  // extern "C"
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+namespace parquet4seastar {
+
+namespace arrow_export_detail {
+
+struct array_holder
+{
+    // Keep the exported buffers alive.
+    std::vector<std::shared_ptr<void>> owners;
+    std::vector<const void*> buffers;
+    std::vector<ArrowArray> children;
+    std::vector<ArrowArray*> child_pointers;
+};
+
+struct schema_holder
+{
+    std::string format;
+    std::string name;
+    std::vector<ArrowSchema> children;
+    std::vector<ArrowSchema*> child_pointers;
+};
+
+inline void release_array(ArrowArray* array) {
+    auto* holder = static_cast<array_holder*>(array->private_data);
+    for (ArrowArray& child : holder->children) {
+        // The consumer may have moved the child out and released it already.
+        if (child.release) {
+            child.release(&child);
+        }
+    }
+    delete holder;
+    array->release = nullptr;
+}
+
+inline void release_schema(ArrowSchema* schema) {
+    auto* holder = static_cast<schema_holder*>(schema->private_data);
+    for (ArrowSchema& child : holder->children) {
+        if (child.release) {
+            child.release(&child);
+        }
+    }
+    delete holder;
+    schema->release = nullptr;
+}
+
+// Fill out. The returned holder stays owned by out; its buffers and children are to be filled in by the caller.
+inline array_holder& init_array(ArrowArray* out, int64_t length, int64_t null_count, size_t n_children) {
+    auto* holder = new array_holder;
+    holder->children.resize(n_children);
+    for (ArrowArray& child : holder->children) {
+        holder->child_pointers.push_back(&child);
+    }
+    *out = ArrowArray{length,   null_count, 0, 0, static_cast<int64_t>(n_children), nullptr,
+                      n_children ? holder->child_pointers.data() : nullptr, nullptr, release_array, holder};
+    return *holder;
+}
+
+// Publish the buffers pushed to the holder of out.
+inline void finish_array(ArrowArray* out) {
+    auto* holder = static_cast<array_holder*>(out->private_data);
+    out->n_buffers = holder->buffers.size();
+    out->buffers = holder->buffers.data();
+}
+
+inline schema_holder& init_schema(ArrowSchema* out, std::string format, std::string name, size_t n_children) {
+    auto* holder = new schema_holder{std::move(format), std::move(name)};
+    holder->children.resize(n_children);
+    for (ArrowSchema& child : holder->children) {
+        holder->child_pointers.push_back(&child);
+    }
+    *out = ArrowSchema{holder->format.c_str(),
+                       holder->name.c_str(),
+                       nullptr,
+                       ARROW_FLAG_NULLABLE,
+                       static_cast<int64_t>(n_children),
+                       n_children ? holder->child_pointers.data() : nullptr,
+                       nullptr,
+                       release_schema,
+                       holder};
+    return *holder;
+}
+
+// Move a container into the holder and return a pointer to its data.
+template <typename Container>
+const void* own(array_holder& holder, Container&& c) {
+    auto owned = std::make_shared<std::decay_t<Container>>(std::forward<Container>(c));
+    holder.owners.push_back(owned);
+    return owned->data();
+}
+
+inline std::string decimal_format(uint32_t precision, uint32_t scale) {
+    // Arrow's decimal128 holds at most 38 digits.
+    if (precision > 38) {
+        throw parquet_exception(seastar::format("DECIMAL precision {} exceeds the 38 digits of decimal128", precision));
+    }
+    return seastar::format("d:{},{}", precision, scale);
+}
+
+template <typename Out, typename In>
+const void* convert(array_holder& holder, const std::vector<In>& values) {
+    std::vector<Out> converted(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        converted[i] = static_cast<Out>(values[i]);
+    }
+    return own(holder, std::move(converted));
+}
+
+inline const void* decimals_from_byte_arrays(array_holder& holder,
+                                             const std::vector<seastar::temporary_buffer<uint8_t>>& values) {
+    std::vector<__int128> converted(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (values[i].size() > 16) {
+            throw parquet_exception(
+              seastar::format("DECIMAL value of {}B does not fit in decimal128", values[i].size()));
+        }
+        // Null slots are empty.
+        if (values[i].size() > 0) {
+            decode_decimals(values[i].get(), values[i].size(), 1, &converted[i]);
+        }
+    }
+    return own(holder, std::move(converted));
+}
+
+// Push the offsets and data buffers of a binary or utf8 array. Return whether 64-bit offsets were needed.
+inline bool push_byte_arrays(array_holder& holder, const std::vector<seastar::temporary_buffer<uint8_t>>& values) {
+    size_t total_size = 0;
+    for (const auto& v : values) {
+        total_size += v.size();
+    }
+    std::vector<uint8_t> data(total_size);
+    auto push_offsets = [&]<typename OffsetT>(OffsetT) {
+        std::vector<OffsetT> offsets(values.size() + 1);
+        OffsetT offset = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+            offsets[i] = offset;
+            if (values[i].size() > 0) {
+                std::memcpy(data.data() + offset, values[i].get(), values[i].size());
+            }
+            offset += values[i].size();
+        }
+        offsets[values.size()] = offset;
+        holder.buffers.push_back(own(holder, std::move(offsets)));
+    };
+    bool large = total_size > static_cast<size_t>(std::numeric_limits<int32_t>::max());
+    if (large) {
+        push_offsets(int64_t{});
+    } else {
+        push_offsets(int32_t{});
+    }
+    holder.buffers.push_back(own(holder, std::move(data)));
+    return large;
+}
+
+inline const void* dense_fixed_len(array_holder& holder, const std::vector<seastar::temporary_buffer<uint8_t>>& values,
+                                   size_t width) {
+    std::vector<uint8_t> data(values.size() * width);
+    for (size_t i = 0; i < values.size(); ++i) {
+        // Null slots are empty.
+        std::memcpy(data.data() + i * width, values[i].get(), std::min(width, values[i].size()));
+    }
+    return own(holder, std::move(data));
+}
+
+/* The Arrow format of a leaf, and the conversion of its values to the Arrow layout.
+ * Returns the format. The value buffers are pushed to holder (after the validity buffer).
+ * Formats are computed with holder == nullptr, which doesn't touch values.
+ */
+template <format::Type::type T>
+std::string export_values(const reader_schema::primitive_node& leaf, std::vector<typename column_batch<T>::output_type>& values,
+                          array_holder* holder) {
+    using namespace logical_type;
+    auto push = [holder](auto&& buffer_fn) {
+        if (holder) {
+            holder->buffers.push_back(buffer_fn(*holder));
+        }
+    };
+    auto zero_copy = [&values](array_holder& h) { return own(h, std::move(values)); };
+    if constexpr (T == format::Type::BOOLEAN) {
+        push([&values](array_holder& h) {
+            std::vector<uint8_t> bits((values.size() + 7) / 8);
+            for (size_t i = 0; i < values.size(); ++i) {
+                bits[i / 8] |= static_cast<uint8_t>(values[i] != 0) << (i % 8);
+            }
+            return own(h, std::move(bits));
+        });
+        return "b";
+    } else if constexpr (T == format::Type::INT32) {
+        return std::visit(
+          overloaded{
+            [&](const INT8&) { push([&](array_holder& h) { return convert<int8_t>(h, values); }); return std::string("c"); },
+            [&](const INT16&) { push([&](array_holder& h) { return convert<int16_t>(h, values); }); return std::string("s"); },
+            [&](const UINT8&) { push([&](array_holder& h) { return convert<uint8_t>(h, values); }); return std::string("C"); },
+            [&](const UINT16&) { push([&](array_holder& h) { return convert<uint16_t>(h, values); }); return std::string("S"); },
+            [&](const UINT32&) { push(zero_copy); return std::string("I"); },
+            [&](const DECIMAL_INT32& t) {
+                std::string arrow_format = decimal_format(t.precision, t.scale);
+                push([&](array_holder& h) { return convert<__int128>(h, values); });
+                return arrow_format;
+            },
+            [&](const DATE&) { push(zero_copy); return std::string("tdD"); },
+            [&](const TIME_INT32&) { push(zero_copy); return std::string("ttm"); },
+            [&](const auto&) { push(zero_copy); return std::string("i"); },
+          },
+          leaf.logical_type);
+    } else if constexpr (T == format::Type::INT64) {
+        return std::visit(
+          overloaded{
+            [&](const UINT64&) { push(zero_copy); return std::string("L"); },
+            [&](const DECIMAL_INT64& t) {
+                std::string arrow_format = decimal_format(t.precision, t.scale);
+                push([&](array_holder& h) { return convert<__int128>(h, values); });
+                return arrow_format;
+            },
+            [&](const TIME_INT64& t) {
+                push(zero_copy);
+                return std::string(t.unit == TIME_INT64::MICROS ? "ttu" : "ttn");
+            },
+            [&](const TIMESTAMP& t) {
+                push(zero_copy);
+                const char* unit = t.unit == TIMESTAMP::MILLIS ? "m" : t.unit == TIMESTAMP::MICROS ? "u" : "n";
+                return seastar::format("ts{}:{}", unit, t.utc_adjustment ? "UTC" : "");
+            },
+            [&](const auto&) { push(zero_copy); return std::string("l"); },
+          },
+          leaf.logical_type);
+    } else if constexpr (T == format::Type::INT96) {
+        push(zero_copy);
+        return "w:12";
+    } else if constexpr (T == format::Type::FLOAT) {
+        push(zero_copy);
+        return "f";
+    } else if constexpr (T == format::Type::DOUBLE) {
+        push(zero_copy);
+        return "g";
+    } else if constexpr (T == format::Type::BYTE_ARRAY) {
+        if (auto* t = std::get_if<DECIMAL_BYTE_ARRAY>(&leaf.logical_type)) {
+            std::string arrow_format = decimal_format(t->precision, t->scale);
+            push([&](array_holder& h) { return decimals_from_byte_arrays(h, values); });
+            return arrow_format;
+        }
+        bool utf8 = std::holds_alternative<STRING>(leaf.logical_type) || std::holds_alternative<ENUM>(leaf.logical_type)
+                    || std::holds_alternative<JSON>(leaf.logical_type);
+        bool large = holder && push_byte_arrays(*holder, values);
+        return utf8 ? (large ? "U" : "u") : (large ? "Z" : "z");
+    } else {
+        static_assert(T == format::Type::FIXED_LEN_BYTE_ARRAY);
+        if (auto* t = std::get_if<DECIMAL_FIXED_LEN_BYTE_ARRAY>(&leaf.logical_type)) {
+            std::string arrow_format = decimal_format(t->precision, t->scale);
+            push([&](array_holder& h) { return decimals_from_byte_arrays(h, values); });
+            return arrow_format;
+        }
+        size_t width = leaf.info.type_length;
+        push([&](array_holder& h) { return dense_fixed_len(h, values, width); });
+        return seastar::format("w:{}", width);
+    }
+}
+
+// The Arrow format of the leaf of batch. Throws for leaves whose type can't be exported.
+template <format::Type::type T>
+std::string leaf_format(const reader_schema::primitive_node& leaf, column_batch<T>& batch) {
+    std::string arrow_format = export_values<T>(leaf, batch.values, nullptr);
+    if (std::holds_alternative<logical_type::UNKNOWN>(leaf.logical_type)) {
+        // Always null. Arrow's null type has no buffers.
+        return "n";
+    }
+    return arrow_format;
+}
+
+// Run export_fn, which fills out_array and out_schema. If it throws, release whatever it exported so far.
+template <typename ExportFn>
+void export_or_release(ArrowArray* out_array, ArrowSchema* out_schema, ExportFn&& export_fn) {
+    *out_array = ArrowArray{};
+    *out_schema = ArrowSchema{};
+    try {
+        export_fn();
+    } catch (...) {
+        if (out_array->release) {
+            out_array->release(out_array);
+        }
+        if (out_schema->release) {
+            out_schema->release(out_schema);
+        }
+        throw;
+    }
+}
+
+inline const void* validity_buffer(array_holder& holder, validity_bitmap&& validity) {
+    return validity.size() ? own(holder, std::move(validity)) : nullptr;
+}
+
+inline std::string path_name(const reader_schema::primitive_node& leaf) {
+    std::string name;
+    for (const std::string& part : leaf.path) {
+        name += name.empty() ? part : "." + part;
+    }
+    return name;
+}
+
+// Throw unless leaf is a leaf of schema with only optional and list ancestors.
+inline void check_exportable(const reader_schema::schema& schema, const reader_schema::primitive_node& leaf) {
+    using namespace reader_schema;
+    // Whether n contains leaf. group is the innermost map or struct above n, if any.
+    auto contains = y_combinator{[&](auto&& contains, const node& n, const node_base* group) -> bool {
+        return std::visit(
+          overloaded{
+            [&](const primitive_node& x) {
+                if (&x != &leaf) {
+                    return false;
+                }
+                if (group) {
+                    throw parquet_exception(seastar::format(
+                      "Column {} is nested in map or struct {}. Exporting it to Arrow is unsupported.", path_name(leaf),
+                      group->info.name));
+                }
+                return true;
+            },
+            [&](const optional_node& x) { return contains(*x.child, group); },
+            [&](const list_node& x) { return contains(*x.element, group); },
+            [&](const map_node& x) { return contains(*x.key, &x) || contains(*x.value, &x); },
+            [&](const struct_node& x) {
+                return std::any_of(x.fields.begin(), x.fields.end(), [&](const node& f) { return contains(f, &x); });
+            },
+          },
+          n);
+    }};
+    for (const node& field : schema.fields) {
+        if (contains(field, nullptr)) {
+            return;
+        }
+    }
+    throw parquet_exception(seastar::format("Column {} is not a leaf of the schema", path_name(leaf)));
+}
+
+}  // namespace arrow_export_detail
+
+/* Export a batch of a leaf column of schema as an Arrow array, with its schema. The batch is consumed.
+ * Repeated ancestors become nested lists ("+l"). Leaves nested in a map or a struct are rejected
+ * with parquet_exception. Both out_array and out_schema have to be released by the consumer
+ * with their release callbacks. If the export throws, nothing is left to release.
+ */
+template <format::Type::type T>
+void export_column_batch(column_batch<T>&& batch, const reader_schema::schema& schema,
+                         const reader_schema::primitive_node& leaf, ArrowArray* out_array, ArrowSchema* out_schema) {
+    using namespace arrow_export_detail;
+    check_exportable(schema, leaf);
+    // Compute the format first, so that unsupported types are rejected before anything is exported.
+    std::string arrow_format = leaf_format<T>(leaf, batch);
+
+    export_or_release(out_array, out_schema, [&] {
+        std::string name = path_name(leaf);
+        ArrowArray* array = out_array;
+        ArrowSchema* array_schema = out_schema;
+        for (list_batch& list : batch.lists) {
+            int64_t length = list.offsets.size() - 1;
+            array_holder& holder = init_array(array, length, list.validity.null_count(), 1);
+            holder.buffers.push_back(validity_buffer(holder, std::move(list.validity)));
+            holder.buffers.push_back(own(holder, std::move(list.offsets)));
+            finish_array(array);
+            schema_holder& s = init_schema(array_schema, "+l", name, 1);
+            array = &holder.children[0];
+            array_schema = &s.children[0];
+            name = "element";
+        }
+        int64_t length = batch.values.size();
+        if (arrow_format == "n") {
+            init_array(array, length, length, 0);
+            finish_array(array);
+        } else {
+            array_holder& holder = init_array(array, length, batch.validity.null_count(), 0);
+            holder.buffers.push_back(validity_buffer(holder, std::move(batch.validity)));
+            export_values<T>(leaf, batch.values, &holder);
+            finish_array(array);
+        }
+        init_schema(array_schema, std::move(arrow_format), name, 0);
+    });
+}
+
+inline void export_column_batch(any_column_batch&& batch, const reader_schema::schema& schema,
+                                const reader_schema::primitive_node& leaf, ArrowArray* out_array,
+                                ArrowSchema* out_schema) {
+    std::visit([&](auto& b) { export_column_batch(std::move(b), schema, leaf, out_array, out_schema); }, batch);
+}
+
+/* Export batches of several leaf columns (e.g. from columnar_reader::read_batch) as a struct array ("+s"),
+ * which is how Arrow consumers exchange record batches. leaves[i] describes batches[i].
+ * Only the record itself becomes a struct. Leaves nested in a map or a struct are rejected, as above.
+ * If any leaf can't be exported, the export throws and leaves nothing to release.
+ */
+inline void export_record_batch(std::vector<any_column_batch>&& batches, const reader_schema::schema& schema,
+                                const std::vector<const reader_schema::primitive_node*>& leaves, ArrowArray* out_array,
+                                ArrowSchema* out_schema) {
+    using namespace arrow_export_detail;
+    assert(batches.size() == leaves.size());
+    // Reject unsupported leaves and types before anything is exported.
+    for (size_t i = 0; i < batches.size(); ++i) {
+        check_exportable(schema, *leaves[i]);
+        std::visit([&](auto& b) { leaf_format(*leaves[i], b); }, batches[i]);
+    }
+    int64_t rows = batches.empty() ? 0 : std::visit([](const auto& b) { return int64_t(b.rows); }, batches[0]);
+    export_or_release(out_array, out_schema, [&] {
+        array_holder& holder = init_array(out_array, rows, 0, batches.size());
+        holder.buffers.push_back(nullptr);
+        finish_array(out_array);
+        schema_holder& record_schema = init_schema(out_schema, "+s", "", batches.size());
+        for (size_t i = 0; i < batches.size(); ++i) {
+            export_column_batch(std::move(batches[i]), schema, *leaves[i], &holder.children[i],
+                                &record_schema.children[i]);
+        }
+    });
+}
+
+}  // namespace parquet4seastar
@@ -145,6 +145,10 @@ class BitReader {
   template <typename T>
   int GetBatch(int num_bits, T* v, int batch_size);
 
+  /// Skips a number of 'num_bits'-wide values without decoding them. Return the number
+  /// of values actually skipped.
+  int Skip(int num_bits, int batch_size);
+
   /// Reads a 'num_bytes'-sized value from the buffer and stores it in 'v'. T
   /// needs to be a little-endian native type and big enough to store
   /// 'num_bytes'. The value is assumed to be byte-aligned so the stream will
@@ -365,6 +369,31 @@ inline int BitReader::GetBatch(int num_bits, T* v, int batch_size) {
   return batch_size;
 }
 
+inline int BitReader::Skip(int num_bits, int batch_size) {
+  assert(num_bits >= 0);
+  if (num_bits == 0) {
+    return batch_size;
+  }
+  uint64_t needed_bits = static_cast<uint64_t>(num_bits) * batch_size;
+  uint64_t remaining_bits = static_cast<uint64_t>(max_bytes_ - byte_offset_) * 8 - bit_offset_;
+  if (remaining_bits < needed_bits) {
+    batch_size = static_cast<int>(remaining_bits / num_bits);
+    needed_bits = static_cast<uint64_t>(num_bits) * batch_size;
+  }
+
+  uint64_t bit_position = static_cast<uint64_t>(byte_offset_) * 8 + bit_offset_ + needed_bits;
+  byte_offset_ = static_cast<int>(bit_position / 8);
+  bit_offset_ = static_cast<int>(bit_position % 8);
+
+  int bytes_remaining = max_bytes_ - byte_offset_;
+  if (__builtin_expect(bytes_remaining >= 8, true)) {
+    memcpy(&buffered_values_, buffer_ + byte_offset_, 8);
+  } else {
+    memcpy(&buffered_values_, buffer_ + byte_offset_, bytes_remaining);
+  }
+  return batch_size;
+}
+
 template <typename T>
 inline bool BitReader::GetAligned(int num_bytes, T* v) {
   if (__builtin_expect(num_bytes > static_cast<int>(sizeof(T)), false)) {
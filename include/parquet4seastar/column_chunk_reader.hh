@@ -22,8 +22,12 @@
 #pragma once
 
 #include <parquet4seastar/compression.hh>
+#include <parquet4seastar/compression_offload.hh>
 #include <parquet4seastar/encoding.hh>
+#include <parquet4seastar/row_selection.hh>
 #include <parquet4seastar/thrift_serdes.hh>
+#include <seastar/core/later.hh>
+#include <seastar/core/preempt.hh>
 
 namespace parquet4seastar {
 
@@ -56,38 +60,157 @@ class column_chunk_reader
 {
    public:
     using output_type = typename value_decoder_traits<T>::output_type;
+    // A dictionary of the column chunk. It stays valid after the reader moves on or is destroyed.
+    // Its memory stays charged to the reader's memory limiter until the last handle to it is destroyed.
+    using dictionary_handle = std::shared_ptr<const std::vector<output_type>>;
 
    private:
+    // A dictionary, together with the memory charged for it.
+    struct charged_dictionary
+    {
+        std::vector<output_type> values;
+        reader_memory_charge charge;
+    };
+
     page_reader _source;
     std::unique_ptr<compressor> _decompressor;
-    bytes _decompression_buffer;
+    compression_offload* _offload;
+    // Reused between pages. Only grows, and is never initialized, since decompression overwrites it anyway.
+    buffer _decompression_buffer;
+    reader_memory_charge _decompression_charge;
+    reader_memory_limiter* _memory_limiter;
     level_decoder _rep_decoder;
     level_decoder _def_decoder;
     value_decoder<T> _val_decoder;
-    std::optional<std::vector<output_type>> _dict;
+    std::shared_ptr<std::vector<output_type>> _dict;
+    std::function<void(const dictionary_handle&)> _dictionary_listener;
     bool _initialized = false;
     bool _eof = false;
     int64_t _page_ordinal = -1;  // Only used for error reporting.
+    size_t _page_kernel = 0;     // The index of the decode kernel of the current page.
    private:
     uint32_t _def_level;
     uint32_t _rep_level;
     std::optional<uint32_t> _type_length;
 
    private:
-    bytes_view decompress(bytes_view compressed, size_t uncompressed_size);
+    seastar::future<bytes_view> decompress(bytes_view compressed, size_t uncompressed_size);
     seastar::future<> load_next_page();
-    void load_dictionary_page(page p);
-    void load_data_page(page p);
-    void load_data_page_v2(page p);
+    seastar::future<> load_page(page p);
+    seastar::future<> load_dictionary_page(page p);
+    seastar::future<> load_data_page(page p);
+    seastar::future<> load_data_page_v2(page p);
+
+    // The number of levels decoded between checks for preemption.
+    static constexpr size_t PREEMPTION_CHECK_INTERVAL = 4096;
+
+    // Where read_batch_internal puts the def levels of a flat optional column, instead of a LevelT array.
+    struct validity_output
+    {
+        uint8_t* bitmap;
+        size_t bit_offset;
+    };
+
+    // DefT is either a LevelT array or a validity_output. RepT is either a LevelT array or nullptr_t,
+    // when rep levels are skipped (flat columns only).
+    // ValueT is either output_type, uint32_t for dictionary indices, a byte_array_arena or a fixed_len_buffer.
+    // The latter two are passed by pointer, and appended to rather than indexed.
+    // If values_read is given, the number of values read is added to it.
+    template <typename DefT, typename RepT, typename ValueT>
+    seastar::future<size_t> read_batch_internal(size_t n, DefT def, RepT rep, ValueT val[],
+                                                size_t* values_read = nullptr);
+    struct chunk_result
+    {
+        size_t levels;
+        size_t values;
+    };
+    // Decode up to n levels of the current page, and their values. Throws if the page is corrupted.
+    template <typename DefT, typename RepT, typename ValueT>
+    chunk_result decode_chunk(size_t n, DefT def, RepT rep, ValueT val[]);
+    void check_chunk(size_t def_levels_read, size_t rep_levels_read, uint64_t max_def, uint64_t max_rep) const;
+    void check_chunk_values(size_t values_read, size_t values_expected) const;
 
+    /* Page decode kernels, for reads of levels and values into arrays (read_batch, read_rows).
+     * There is one per combination of the sources of def and rep levels and the encoding of values,
+     * instantiated at compile time. The kernel is selected once per page, when it is loaded. Levels read from
+     * a single RLE run, or absent in required and flat columns, are then filled without decoding,
+     * and PLAIN and dictionary values are decoded without dispatching on the encoding.
+     */
+    enum class value_source : uint8_t { plain, dictionary, other };
+    static constexpr size_t value_source_count = 3;
+    static constexpr size_t page_kernel_count =
+      level_decoder::source_count * level_decoder::source_count * value_source_count;
+    template <typename LevelT>
+    using page_kernel = chunk_result (column_chunk_reader::*)(size_t n, LevelT def[], LevelT rep[], output_type val[]);
+    template <typename LevelT, level_decoder::source Def, level_decoder::source Rep, value_source Val>
+    chunk_result decode_page_chunk(size_t n, LevelT def[], LevelT rep[], output_type val[]);
+    template <typename LevelT, size_t... I>
+    static constexpr std::array<page_kernel<LevelT>, sizeof...(I)> make_page_kernels(std::index_sequence<I...>) {
+        constexpr size_t n_values = value_source_count;
+        constexpr size_t n_levels = level_decoder::source_count;
+        return {&column_chunk_reader::decode_page_chunk<LevelT, level_decoder::source(I / n_values / n_levels),
+                                                        level_decoder::source(I / n_values % n_levels),
+                                                        value_source(I % n_values)>...};
+    }
+    template <typename LevelT>
+    static page_kernel<LevelT> get_page_kernel(size_t index) {
+        static constexpr auto kernels = make_page_kernels<LevelT>(std::make_index_sequence<page_kernel_count>{});
+        return kernels[index];
+    }
+    void select_page_kernel();
+    // Decode n levels, validating them and counting the non-null values into *values. Return the number decoded.
+    template <typename LevelT>
+    size_t decode_def_levels(size_t n, LevelT def[], uint32_t* values, uint64_t* max_level);
+    size_t decode_def_levels(size_t n, validity_output def, uint32_t* values, uint64_t* max_level);
     template <typename LevelT>
-    seastar::future<size_t> read_batch_internal(size_t n, LevelT def[], LevelT rep[], output_type val[]);
+    size_t decode_rep_levels(size_t n, LevelT rep[], uint64_t* max_level);
+    size_t decode_rep_levels(size_t n, std::nullptr_t, uint64_t*) { return _rep_decoder.skip(n); }
+    template <typename LevelT>
+    static LevelT* levels_after(LevelT levels[], size_t n) {
+        return levels + n;
+    }
+    static validity_output levels_after(validity_output def, size_t n) { return {def.bitmap, def.bit_offset + n}; }
+    static std::nullptr_t levels_after(std::nullptr_t, size_t) { return nullptr; }
+    template <typename ValueT>
+    size_t decode_values(size_t n, ValueT val[]);
+    template <typename ValueT>
+    static ValueT* values_after(ValueT val[], size_t n) {
+        if constexpr (is_byte_array_arena_v<ValueT> || std::is_same_v<ValueT, fixed_len_buffer>) {
+            return val;
+        } else {
+            return val + n;
+        }
+    }
+
+    // The levels of up to n whole rows from the current page.
+    struct row_span
+    {
+        size_t levels = 0;
+        size_t rows = 0;
+        // Set when the span ends on a row boundary within the page.
+        bool done = false;
+    };
+    row_span find_rows(size_t n);
+    row_span skip_in_page(size_t n);
+    seastar::future<size_t> skip_next_page(size_t n);
+    seastar::future<size_t> skip_internal(size_t n);
+    template <typename LevelT>
+    seastar::future<size_t> read_rows_internal(size_t n, std::vector<LevelT>& def, std::vector<LevelT>& rep,
+                                               std::vector<output_type>& val);
 
    public:
+    // If offload is given, large pages are decompressed on its worker threads.
+    // If memory_limiter is given, decompression buffers and dictionaries are charged against it.
+    // Both have to outlive the reader, and memory_limiter has to outlive its dictionary handles too.
     explicit column_chunk_reader(page_reader&& source, format::CompressionCodec::type codec, uint32_t def_level,
-                                 uint32_t rep_level, std::optional<uint32_t> type_length)
+                                 uint32_t rep_level, std::optional<uint32_t> type_length,
+                                 compression_offload* offload = nullptr,
+                                 reader_memory_limiter* memory_limiter = nullptr)
         : _source{std::move(source)},
           _decompressor{compressor::make(codec)},
+          _offload{offload},
+          _decompression_charge{memory_limiter},
+          _memory_limiter{memory_limiter},
           _rep_decoder{rep_level},
           _def_decoder{def_level},
           _val_decoder{type_length},
@@ -97,61 +220,363 @@ class column_chunk_reader
     // Read a batch of n (rep, def, value) triplets. The last batch may be smaller than n.
     // Return the number of triplets read. Note that null values are not read into the output array.
     // Example output: def == [1, 1, 0, 1, 0], rep = [0, 0, 0, 0, 0], val = ["a", "b", "d"].
+    // If values_read is given, the number of values read is added to it, which saves counting the def levels.
+    // It has to stay alive until the returned future resolves.
+    template <typename LevelT>
+    seastar::future<size_t> read_batch(size_t n, LevelT def[], LevelT rep[], output_type val[],
+                                       size_t* values_read = nullptr);
+    // The same, but with byte array values appended to a single buffer rather than returned
+    // as a temporary_buffer each. Only for BYTE_ARRAY and FIXED_LEN_BYTE_ARRAY columns.
+    template <typename LevelT, typename OffsetT>
+    seastar::future<size_t> read_batch(size_t n, LevelT def[], LevelT rep[], byte_array_arena<OffsetT>& val);
+    // The same, but with FIXED_LEN_BYTE_ARRAY values written back to back into val, type_length bytes each.
+    // val has to have room for n values.
+    template <typename LevelT>
+    seastar::future<size_t> read_batch(size_t n, LevelT def[], LevelT rep[], fixed_len_buffer& val);
+    // Skip n rows without decoding their values. Return the number of rows skipped (fewer than n at the end
+    // of the chunk). Pages which hold only skipped rows are not decompressed at all.
+    // In nested columns a row spans all levels up to the next repetition level 0, so skip() must be called
+    // on a row boundary, and it leaves the reader on one.
+    seastar::future<size_t> skip(size_t n);
+    // Read n whole rows, appending their levels and values to def, rep and val. Return the number of rows read
+    // (fewer than n at the end of the chunk). As with skip(), the reader has to be on a row boundary.
+    // The vectors have to stay alive until the returned future resolves.
+    template <typename LevelT>
+    seastar::future<size_t> read_rows(size_t n, std::vector<LevelT>& def, std::vector<LevelT>& rep,
+                                      std::vector<output_type>& val);
+    // Read the rows picked by selection, with row numbers counted from the current position of the reader.
+    // The rows in between are skipped as with skip(). The levels and values of the selected rows are appended
+    // to def, rep and val, compacted. Return the number of selected rows read (fewer than selection.row_count()
+    // at the end of the chunk). The vectors have to stay alive until the returned future resolves.
     template <typename LevelT>
-    seastar::future<size_t> read_batch(size_t n, LevelT def[], LevelT rep[], output_type val[]);
+    seastar::future<size_t> read_selected(const row_selection& selection, std::vector<LevelT>& def,
+                                          std::vector<LevelT>& rep, std::vector<output_type>& val);
+
+    /* Flat optional columns (def_level 1, rep_level 0) can be read with a validity bitmap instead of def levels.
+     * Their def levels are 1 bit wide, so RLE literal runs of them already are LSB-first bitmaps. They are
+     * copied 32 levels at a time, and repeated runs are filled bytewise. Values are dense, as in read_batch.
+     */
+    // Read a batch of n slots. Bit i of validity, counted from bit_offset, is set if slot i is non-null.
+    // The bits before bit_offset are preserved; the bits after the last slot read, up to the end of its byte,
+    // are cleared. Return the number of slots read. values_read is as in read_batch.
+    seastar::future<size_t> read_batch_validity(size_t n, uint8_t validity[], size_t bit_offset, output_type val[],
+                                                size_t* values_read = nullptr);
+
+    /* Pages whose definition levels are a single RLE run (or absent, in required columns) hold either
+     * no nulls or only nulls. Their levels are produced without decoding or validating them one by one, so
+     * optional columns without nulls read at the speed of required ones. The flags describe the levels left
+     * in the current page; both are false when the page is mixed, or before the first page is loaded.
+     */
+    bool page_all_valid() const {
+        std::optional<uint32_t> def = _def_decoder.constant_level();
+        return _initialized && def && *def == _def_level;
+    }
+    bool page_all_null() const {
+        std::optional<uint32_t> def = _def_decoder.constant_level();
+        return _initialized && def && *def < _def_level;
+    }
+
+    /* Dictionary-preserving reads. Values of dictionary-encoded pages are returned as indices into dictionary(),
+     * rather than looked up. This keeps low-cardinality columns small, and lets grouping and equality filters
+     * work on the indices.
+     *
+     * Writers fall back to other encodings when the dictionary grows too big, so a chunk may end with pages
+     * which are not dictionary-encoded. read_batch_indices returns 0 both at the end of the chunk and at the first
+     * such page. The two are told apart by dictionary_encoded(); in the latter case, the rest of the chunk has
+     * to be read with read_batch().
+     */
+    // Read a batch of n (rep, def, dictionary index) triplets. As in read_batch, nulls have no index.
+    template <typename LevelT>
+    seastar::future<size_t> read_batch_indices(size_t n, LevelT def[], LevelT rep[], uint32_t idx[]);
+    // Whether the current page is dictionary-encoded.
+    bool dictionary_encoded() const { return _val_decoder.dictionary_encoded(); }
+    // The current dictionary. Empty until the dictionary page is read.
+    dictionary_handle dictionary() const { return _dict; }
+    // Call listener whenever a new dictionary is loaded, i.e. before the first index referring to it is returned.
+    void on_dictionary_change(std::function<void(const dictionary_handle&)> listener) {
+        _dictionary_listener = std::move(listener);
+    }
 };
 
 template <format::Type::type T>
-template <typename LevelT>
-seastar::future<size_t> column_chunk_reader<T>::read_batch_internal(size_t n, LevelT def[], LevelT rep[],
-                                                                    output_type val[]) {
-    if (_eof) {
+template <typename DefT, typename RepT, typename ValueT>
+seastar::future<size_t> column_chunk_reader<T>::read_batch_internal(size_t n, DefT def, RepT rep, ValueT val[],
+                                                                    size_t* values_out) {
+    constexpr bool indices = std::is_same_v<ValueT, uint32_t>;
+    if (_eof || n == 0) {
         return seastar::make_ready_future<size_t>(0);
     }
     if (not _initialized) {
-        return load_next_page().then([this, n, def, rep, val] { return read_batch_internal(n, def, rep, val); });
+        return load_next_page().then(
+          [this, n, def, rep, val, values_out] { return read_batch_internal(n, def, rep, val, values_out); });
     }
-    size_t def_levels_read = _def_decoder.read_batch(n, def);
-    size_t rep_levels_read = _rep_decoder.read_batch(n, rep);
-    if (def_levels_read != rep_levels_read) {
-        return seastar::make_exception_future<size_t>(parquet_exception::corrupted_file(
-          seastar::format("Number of definition levels {} does not equal the number of repetition levels {} in batch",
-                          def_levels_read, rep_levels_read)));
+    if (indices && !_val_decoder.dictionary_encoded()) {
+        return seastar::make_ready_future<size_t>(0);
     }
-    if (def_levels_read == 0) {
+    // Large batches are decoded in chunks. If we run out of our time slice between chunks,
+    // we yield to other tasks before continuing.
+    size_t levels_read = 0;
+    size_t values_read = 0;
+    while (levels_read < n) {
+        size_t chunk_size = std::min(n - levels_read, PREEMPTION_CHECK_INTERVAL);
+        chunk_result chunk;
+        try {
+            chunk = decode_chunk(chunk_size, levels_after(def, levels_read), levels_after(rep, levels_read),
+                                 values_after(val, values_read));
+        } catch (...) {
+            return seastar::make_exception_future<size_t>(std::current_exception());
+        }
+        if (chunk.levels == 0) {
+            break;
+        }
+        levels_read += chunk.levels;
+        values_read += chunk.values;
+        if (chunk.levels < chunk_size) {
+            // End of page.
+            break;
+        }
+        if (levels_read < n && seastar::need_preempt()) {
+            if (values_out) {
+                *values_out += values_read;
+            }
+            return seastar::yield().then([this, n, def, rep, val, values_out, levels_read, values_read] {
+                return read_batch_internal(n - levels_read, levels_after(def, levels_read),
+                                           levels_after(rep, levels_read), values_after(val, values_read),
+                                           values_out)
+                  .then([levels_read](size_t rest) { return levels_read + rest; });
+            });
+        }
+    }
+    if (levels_read == 0) {
         _initialized = false;
-        return read_batch_internal(n, def, rep, val);
+        return read_batch_internal(n, def, rep, val, values_out);
     }
-    for (size_t i = 0; i < def_levels_read; ++i) {
-        if (def[i] < 0 || def[i] > static_cast<LevelT>(_def_level)) {
-            return seastar::make_exception_future<size_t>(parquet_exception::corrupted_file(
-              seastar::format("Definition level ({}) out of range (0 to {})", def[i], _def_level)));
-        }
-        if (rep[i] < 0 || rep[i] > static_cast<LevelT>(_rep_level)) {
-            return seastar::make_exception_future<size_t>(parquet_exception::corrupted_file(
-              seastar::format("Repetition level ({}) out of range (0 to {})", rep[i], _rep_level)));
+    if (values_out) {
+        *values_out += values_read;
+    }
+    return seastar::make_ready_future<size_t>(levels_read);
+}
+
+template <format::Type::type T>
+template <typename DefT, typename RepT, typename ValueT>
+typename column_chunk_reader<T>::chunk_result column_chunk_reader<T>::decode_chunk(size_t n, DefT def, RepT rep,
+                                                                                   ValueT val[]) {
+    if constexpr (std::is_pointer_v<DefT> && std::is_same_v<DefT, RepT> && std::is_same_v<ValueT, output_type>) {
+        return (this->*get_page_kernel<std::remove_pointer_t<DefT>>(_page_kernel))(n, def, rep, val);
+    } else {
+        // Levels are validated and the non-null values counted while they are decoded.
+        uint32_t values_to_read = 0;
+        uint64_t max_def = 0;
+        uint64_t max_rep = 0;
+        size_t def_levels_read = decode_def_levels(n, def, &values_to_read, &max_def);
+        size_t rep_levels_read = decode_rep_levels(n, rep, &max_rep);
+        check_chunk(def_levels_read, rep_levels_read, max_def, max_rep);
+        if (def_levels_read == 0) {
+            return {0, 0};
         }
+        size_t values_read = decode_values(values_to_read, val);
+        check_chunk_values(values_read, values_to_read);
+        return {def_levels_read, values_read};
+    }
+}
+
+template <format::Type::type T>
+template <typename LevelT, level_decoder::source Def, level_decoder::source Rep,
+          typename column_chunk_reader<T>::value_source Val>
+typename column_chunk_reader<T>::chunk_result column_chunk_reader<T>::decode_page_chunk(size_t n, LevelT def[],
+                                                                                        LevelT rep[],
+                                                                                        output_type val[]) {
+    uint32_t values_to_read = 0;
+    uint32_t rep_matches = 0;
+    uint64_t max_def = 0;
+    uint64_t max_rep = 0;
+    size_t def_levels_read = _def_decoder.read_batch_from<Def>(n, def, _def_level, &values_to_read, &max_def);
+    size_t rep_levels_read = _rep_decoder.read_batch_from<Rep>(n, rep, _rep_level, &rep_matches, &max_rep);
+    check_chunk(def_levels_read, rep_levels_read, max_def, max_rep);
+    if (def_levels_read == 0) {
+        return {0, 0};
+    }
+    size_t values_read;
+    if constexpr (Val == value_source::plain) {
+        values_read = _val_decoder.read_plain(values_to_read, val);
+    } else if constexpr (Val == value_source::dictionary) {
+        values_read = _val_decoder.read_dictionary(values_to_read, val);
+    } else {
+        values_read = _val_decoder.read_batch(values_to_read, val);
     }
-    size_t values_to_read =
-      _def_level == 0 ? def_levels_read : std::count(def, def + def_levels_read, static_cast<LevelT>(_def_level));
-    size_t values_read = _val_decoder.read_batch(values_to_read, val);
-    if (values_read != values_to_read) {
-        return seastar::make_exception_future<size_t>(parquet_exception::corrupted_file(seastar::format(
-          "Number of values in batch {} is less than indicated by def levels {}", values_read, values_to_read)));
+    check_chunk_values(values_read, values_to_read);
+    return {def_levels_read, values_read};
+}
+
+template <format::Type::type T>
+template <typename LevelT>
+size_t column_chunk_reader<T>::decode_def_levels(size_t n, LevelT def[], uint32_t* values, uint64_t* max_level) {
+    return _def_decoder.read_batch(n, def, _def_level, values, max_level);
+}
+
+template <format::Type::type T>
+size_t column_chunk_reader<T>::decode_def_levels(size_t n, validity_output def, uint32_t* values,
+                                                 uint64_t* max_level) {
+    BitmapWriter writer{def.bitmap, static_cast<int64_t>(def.bit_offset)};
+    size_t n_read = _def_decoder.read_bitmap(n, writer, values, max_level);
+    writer.Finish();
+    return n_read;
+}
+
+template <format::Type::type T>
+template <typename LevelT>
+size_t column_chunk_reader<T>::decode_rep_levels(size_t n, LevelT rep[], uint64_t* max_level) {
+    uint32_t matches = 0;
+    return _rep_decoder.read_batch(n, rep, _rep_level, &matches, max_level);
+}
+
+template <format::Type::type T>
+template <typename ValueT>
+size_t column_chunk_reader<T>::decode_values(size_t n, ValueT val[]) {
+    if constexpr (std::is_same_v<ValueT, uint32_t>) {
+        return _val_decoder.read_indices(n, val);
+    } else if constexpr (is_byte_array_arena_v<ValueT> || std::is_same_v<ValueT, fixed_len_buffer>) {
+        return _val_decoder.read_batch(n, *val);
+    } else {
+        return _val_decoder.read_batch(n, val);
     }
-    return seastar::make_ready_future<size_t>(def_levels_read);
+}
+
+template <format::Type::type T>
+template <typename LevelT, typename OffsetT>
+seastar::future<size_t> inline column_chunk_reader<T>::read_batch(size_t n, LevelT def[], LevelT rep[],
+                                                                  byte_array_arena<OffsetT>& val) {
+    static_assert(T == format::Type::BYTE_ARRAY || T == format::Type::FIXED_LEN_BYTE_ARRAY);
+    return read_batch_internal(n, def, rep, &val).handle_exception_type([this](const std::exception& e) {
+        return seastar::make_exception_future<size_t>(
+          parquet_exception(seastar::format("Error while reading page number {}: {}", _page_ordinal, e.what())));
+    });
 }
 
 template <format::Type::type T>
 template <typename LevelT>
 seastar::future<size_t> inline column_chunk_reader<T>::read_batch(size_t n, LevelT def[], LevelT rep[],
-                                                                  output_type val[]) {
-    return read_batch_internal(n, def, rep, val).handle_exception_type([this](const std::exception& e) {
+                                                                  fixed_len_buffer& val) {
+    static_assert(T == format::Type::FIXED_LEN_BYTE_ARRAY);
+    return read_batch_internal(n, def, rep, &val).handle_exception_type([this](const std::exception& e) {
         return seastar::make_exception_future<size_t>(
           parquet_exception(seastar::format("Error while reading page number {}: {}", _page_ordinal, e.what())));
     });
 }
 
+template <format::Type::type T>
+template <typename LevelT>
+seastar::future<size_t> inline column_chunk_reader<T>::read_batch(size_t n, LevelT def[], LevelT rep[],
+                                                                  output_type val[], size_t* values_read) {
+    return read_batch_internal(n, def, rep, val, values_read).handle_exception_type([this](const std::exception& e) {
+        return seastar::make_exception_future<size_t>(
+          parquet_exception(seastar::format("Error while reading page number {}: {}", _page_ordinal, e.what())));
+    });
+}
+
+template <format::Type::type T>
+seastar::future<size_t> inline column_chunk_reader<T>::read_batch_validity(size_t n, uint8_t validity[],
+                                                                           size_t bit_offset, output_type val[],
+                                                                           size_t* values_read) {
+    if (_def_level != 1 || _rep_level != 0) {
+        return seastar::make_exception_future<size_t>(parquet_exception(seastar::format(
+          "read_batch_validity needs a flat optional column (max def level {}, max rep level {})",
+          _def_level, _rep_level)));
+    }
+    return read_batch_internal(n, validity_output{validity, bit_offset}, nullptr, val, values_read)
+      .handle_exception_type([this](const std::exception& e) {
+          return seastar::make_exception_future<size_t>(
+            parquet_exception(seastar::format("Error while reading page number {}: {}", _page_ordinal, e.what())));
+      });
+}
+
+template <format::Type::type T>
+template <typename LevelT>
+seastar::future<size_t> inline column_chunk_reader<T>::read_batch_indices(size_t n, LevelT def[], LevelT rep[],
+                                                                          uint32_t idx[]) {
+    return read_batch_internal(n, def, rep, idx).handle_exception_type([this](const std::exception& e) {
+        return seastar::make_exception_future<size_t>(
+          parquet_exception(seastar::format("Error while reading page number {}: {}", _page_ordinal, e.what())));
+    });
+}
+
+template <format::Type::type T>
+template <typename LevelT>
+seastar::future<size_t> column_chunk_reader<T>::read_rows_internal(size_t n, std::vector<LevelT>& def,
+                                                                   std::vector<LevelT>& rep,
+                                                                   std::vector<output_type>& val) {
+    size_t rows_read = 0;
+    while (!_eof) {
+        if (not _initialized) {
+            co_await load_next_page();
+            continue;
+        }
+        row_span span = find_rows(n - rows_read);
+        if (span.levels == 0 && !span.done) {
+            // End of page. In nested columns, the last row may continue on the next page.
+            _initialized = false;
+            continue;
+        }
+        size_t levels_offset = def.size();
+        size_t values_offset = val.size();
+        def.resize(levels_offset + span.levels);
+        rep.resize(levels_offset + span.levels);
+        val.resize(values_offset + span.levels);
+        size_t values_read = 0;
+        size_t levels_read = co_await read_batch_internal(span.levels, def.data() + levels_offset,
+                                                          rep.data() + levels_offset, val.data() + values_offset,
+                                                          &values_read);
+        if (levels_read != span.levels) {
+            throw parquet_exception::corrupted_file(seastar::format(
+              "Number of levels read {} is less than the number of levels in rows {}", levels_read, span.levels));
+        }
+        val.resize(values_offset + values_read);
+        rows_read += span.rows;
+        if (span.done) {
+            break;
+        }
+    }
+    co_return rows_read;
+}
+
+template <format::Type::type T>
+template <typename LevelT>
+seastar::future<size_t> column_chunk_reader<T>::read_rows(size_t n, std::vector<LevelT>& def, std::vector<LevelT>& rep,
+                                                          std::vector<output_type>& val) {
+    return read_rows_internal(n, def, rep, val).handle_exception_type([this](const std::exception& e) {
+        return seastar::make_exception_future<size_t>(
+          parquet_exception(seastar::format("Error while reading page number {}: {}", _page_ordinal, e.what())));
+    });
+}
+
+template <format::Type::type T>
+template <typename LevelT>
+seastar::future<size_t> column_chunk_reader<T>::read_selected(const row_selection& selection, std::vector<LevelT>& def,
+                                                              std::vector<LevelT>& rep, std::vector<output_type>& val) {
+    uint64_t position = 0;
+    size_t rows_read = 0;
+    try {
+        for (const row_range& range : selection.ranges()) {
+            if (range.begin > position) {
+                size_t rows_skipped = co_await skip_internal(range.begin - position);
+                position += rows_skipped;
+                if (position < range.begin) {
+                    break;
+                }
+            }
+            size_t range_rows_read = co_await read_rows_internal(range.end - range.begin, def, rep, val);
+            position += range_rows_read;
+            rows_read += range_rows_read;
+            if (position < range.end) {
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        throw parquet_exception(seastar::format("Error while reading page number {}: {}", _page_ordinal, e.what()));
+    }
+    co_return rows_read;
+}
+
 extern template class column_chunk_reader<format::Type::INT32>;
 extern template class column_chunk_reader<format::Type::INT64>;
 extern template class column_chunk_reader<format::Type::INT96>;
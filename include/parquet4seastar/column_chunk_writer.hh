@@ -22,6 +22,7 @@
 #pragma once
 
 #include <boost/iterator/counting_iterator.hpp>
+#include <cstring>
 #include <parquet4seastar/bytes.hh>
 #include <parquet4seastar/column_chunk_reader.hh>
 #include <parquet4seastar/encoding.hh>
@@ -38,6 +39,9 @@ struct writer_options
     uint32_t rep_level;
     format::Encoding::type encoding;
     format::CompressionCodec::type compression;
+    compressor_options compression_options = {};
+    // If set, large pages are compressed on the worker threads of offload. It has to outlive the writer.
+    compression_offload* offload = nullptr;
 };
 
 template <format::Type::type ParquetType>
@@ -48,9 +52,24 @@ class column_chunk_writer
     rle_builder _def_encoder;
     std::unique_ptr<value_encoder<ParquetType>> _val_encoder;
     std::unique_ptr<compressor> _compressor;
-    std::vector<bytes> _pages;
+    compression_offload* _offload;
+
+    struct page_data
+    {
+        buffer storage;
+        size_t size;
+        // Not compressed yet. See compress_deferred_page().
+        bool deferred = false;
+        bytes_view view() const { return {storage.data(), size}; }
+    };
+    // Finished pages are kept until the column chunk is flushed. Their buffers are then recycled
+    // for the pages of the next chunk, so that steady-state writing doesn't allocate per page.
+    std::vector<page_data> _pages;
+    std::vector<buffer> _free_buffers;
+    // Scratch space for assembling pages before compression.
+    buffer _uncompressed_page;
     std::vector<format::PageHeader> _page_headers;
-    bytes _dict_page;
+    std::optional<page_data> _dict_page;
     format::PageHeader _dict_page_header;
     std::unordered_set<format::Encoding::type> _used_encodings;
     uint64_t _levels_in_current_page = 0;
@@ -58,17 +77,24 @@ class column_chunk_writer
     uint32_t _rep_level;
     uint32_t _def_level;
     uint64_t _rows_written = 0;
+    // The compressed size of the pages of the current chunk, except those which are still deferred.
     size_t _estimated_chunk_size = 0;
+    // The uncompressed size of the pages of the current chunk which are still deferred.
+    size_t _deferred_size = 0;
+    // The sizes of all pages compressed by this writer so far, for estimating the size of deferred pages.
+    uint64_t _compressed_size_seen = 0;
+    uint64_t _uncompressed_size_seen = 0;
 
    public:
     using input_type = typename value_encoder<ParquetType>::input_type;
 
     column_chunk_writer(uint32_t def_level, uint32_t rep_level, std::unique_ptr<value_encoder<ParquetType>> val_encoder,
-                        std::unique_ptr<compressor> compressor)
+                        std::unique_ptr<compressor> compressor, compression_offload* offload = nullptr)
         : _rep_encoder{bit_width(rep_level)},
           _def_encoder{bit_width(def_level)},
           _val_encoder{std::move(val_encoder)},
           _compressor{std::move(compressor)},
+          _offload{offload},
           _used_encodings(10),
           _rep_level{rep_level},
           _def_level{def_level} {}
@@ -107,32 +133,55 @@ class column_chunk_writer
     }
 
     size_t current_page_max_size() const {
-        size_t def_size = _def_level ? _def_encoder.max_encoded_size() : 0;
-        size_t rep_size = _rep_level ? _rep_encoder.max_encoded_size() : 0;
+        // Levels are prefixed with their size.
+        size_t def_size = _def_level ? sizeof(uint32_t) + _def_encoder.max_encoded_size() : 0;
+        size_t rep_size = _rep_level ? sizeof(uint32_t) + _rep_encoder.max_encoded_size() : 0;
         size_t value_size = _val_encoder->max_encoded_size();
         return def_size + rep_size + value_size;
     }
 
     void flush_page() {
-        bytes page;
         size_t page_max_size = current_page_max_size();
-        page.reserve(page_max_size);
+        // Uncompressed pages are assembled in place. Otherwise, they are assembled in scratch space
+        // and compressed from there. Large pages are compressed later, in flush_chunk or sync_flush_chunk,
+        // if they are to be offloaded, since flush_page can't wait for the result. The first page is never
+        // deferred, so that there is a compression ratio to estimate the size of deferred pages with.
+        bool uncompressed = _compressor->type() == format::CompressionCodec::UNCOMPRESSED;
+        bool deferred = !uncompressed && _offload && _uncompressed_size_seen > 0
+                        && _offload->should_offload(page_max_size);
+        bool in_place = uncompressed || deferred;
+        page_data compressed_page{in_place ? take_buffer(page_max_size) : buffer{}, 0, deferred};
+        if (!in_place && _uncompressed_page.size() < page_max_size) {
+            _uncompressed_page = buffer{page_max_size};
+        }
+        byte* page = in_place ? compressed_page.storage.data() : _uncompressed_page.data();
+        size_t page_size = 0;
+        auto append_levels = [page, &page_size](rle_builder& encoder) {
+            bytes_view levels = encoder.view();
+            uint32_t levels_size = levels.size();
+            std::memcpy(page + page_size, &levels_size, sizeof(levels_size));
+            page_size += sizeof(levels_size);
+            std::memcpy(page + page_size, levels.data(), levels.size());
+            page_size += levels.size();
+        };
         if (_rep_level > 0) {
-            bytes_view levels = _rep_encoder.view();
-            append_raw_bytes<uint32_t>(page, levels.size());
-            page.insert(page.end(), levels.begin(), levels.end());
+            append_levels(_rep_encoder);
         }
         if (_def_level > 0) {
-            bytes_view levels = _def_encoder.view();
-            append_raw_bytes<uint32_t>(page, levels.size());
-            page.insert(page.end(), levels.begin(), levels.end());
+            append_levels(_def_encoder);
         }
-        size_t data_offset = page.size();
-        page.resize(page_max_size);
-        auto flush_info = _val_encoder->flush(page.data() + data_offset);
-        page.resize(data_offset + flush_info.size);
+        auto flush_info = _val_encoder->flush(page + page_size);
+        page_size += flush_info.size;
 
-        bytes compressed_page = _compressor->compress(page);
+        if (in_place) {
+            compressed_page.size = page_size;
+        } else {
+            compressed_page.storage = take_buffer(_compressor->max_compressed_size(page_size));
+            std::span<byte> out{compressed_page.storage.data(), compressed_page.storage.size()};
+            compressed_page.size = _compressor->compress(bytes_view{page, page_size}, out);
+            _uncompressed_size_seen += page_size;
+            _compressed_size_seen += compressed_page.size;
+        }
 
         format::DataPageHeader data_page_header;
         data_page_header.__set_num_values(_levels_in_current_page);
@@ -141,11 +190,15 @@ class column_chunk_writer
         data_page_header.__set_repetition_level_encoding(format::Encoding::RLE);
         format::PageHeader page_header;
         page_header.__set_type(format::PageType::DATA_PAGE);
-        page_header.__set_uncompressed_page_size(page.size());
-        page_header.__set_compressed_page_size(compressed_page.size());
+        page_header.__set_uncompressed_page_size(page_size);
+        page_header.__set_compressed_page_size(compressed_page.size);
         page_header.__set_data_page_header(data_page_header);
 
-        _estimated_chunk_size += compressed_page.size();
+        if (deferred) {
+            _deferred_size += compressed_page.size;
+        } else {
+            _estimated_chunk_size += compressed_page.size;
+        }
         _def_encoder.clear();
         _rep_encoder.clear();
         _levels_in_current_page = 0;
@@ -183,26 +236,27 @@ class column_chunk_writer
             });
         };
 
-        return [this, metadata, write_page, &sink] {
-            if (_val_encoder->view_dict()) {
-                fill_dictionary_page();
-                metadata->__set_dictionary_page_offset(metadata->total_compressed_size);
-                return write_page(_dict_page_header, _dict_page);
-            } else {
-                return seastar::make_ready_future<>();
-            }
-        }()
+        return compress_deferred_pages()
+                 .then([this, metadata, write_page] {
+                     if (_val_encoder->view_dict()) {
+                         fill_dictionary_page();
+                         metadata->__set_dictionary_page_offset(metadata->total_compressed_size);
+                         return write_page(_dict_page_header, _dict_page->view());
+                     } else {
+                         return seastar::make_ready_future<>();
+                     }
+                 })
                  .then([this, write_page, metadata, &sink] {
                      metadata->__set_data_page_offset(metadata->total_compressed_size);
                      using it = boost::counting_iterator<size_t>;
                      return seastar::do_for_each(
                        it(0), it(_page_headers.size()), [this, metadata, write_page, &sink](size_t i) {
                            metadata->num_values += _page_headers[i].data_page_header.num_values;
-                           return write_page(_page_headers[i], _pages[i]);
+                           return write_page(_page_headers[i], _pages[i].view());
                        });
                  })
                  .then([this, metadata] {
-                     _pages.clear();
+                     recycle_pages();
                      _page_headers.clear();
                      _estimated_chunk_size = 0;
                      return metadata;
@@ -214,6 +268,15 @@ class column_chunk_writer
         if (_levels_in_current_page > 0) {
             flush_page();
         }
+        // There is no waiting for the worker threads here, so deferred pages are compressed inline.
+        for (size_t i = 0; i < _pages.size(); ++i) {
+            if (_pages[i].deferred) {
+                buffer out = take_buffer(_compressor->max_compressed_size(_pages[i].size));
+                size_t compressed_size =
+                  _compressor->compress(_pages[i].view(), std::span<byte>{out.data(), out.size()});
+                finish_deferred_page(i, std::move(out), compressed_size);
+            }
+        }
         auto metadata = seastar::make_lw_shared<format::ColumnMetaData>();
         metadata->__set_type(ParquetType);
         metadata->__set_encodings(std::vector<format::Encoding::type>(_used_encodings.begin(), _used_encodings.end()));
@@ -239,26 +302,94 @@ class column_chunk_writer
         if (_val_encoder->view_dict()) {
             fill_dictionary_page();
             metadata->__set_dictionary_page_offset(metadata->total_compressed_size);
-            write_page(_dict_page_header, _dict_page);
+            write_page(_dict_page_header, _dict_page->view());
         }
         metadata->__set_data_page_offset(metadata->total_compressed_size);
         for (size_t i : std::ranges::iota_view(0U, _page_headers.size())) {
             metadata->num_values += _page_headers[i].data_page_header.num_values;
-            write_page(_page_headers[i], _pages[i]);
+            write_page(_page_headers[i], _pages[i].view());
         }
-        _pages.clear();
+        recycle_pages();
         _page_headers.clear();
         _estimated_chunk_size = 0;
         return metadata;
     }
 
+    void set_yield_hook(yield_hook hook) { _val_encoder->set_yield_hook(std::move(hook)); }
+
     size_t rows_written() const { return _rows_written; }
-    size_t estimated_chunk_size() const { return _estimated_chunk_size; }
+    // Deferred pages are counted with the compression ratio of the pages compressed so far.
+    size_t estimated_chunk_size() const {
+        if (_deferred_size == 0) {
+            return _estimated_chunk_size;
+        }
+        double ratio = static_cast<double>(_compressed_size_seen) / _uncompressed_size_seen;
+        return _estimated_chunk_size + static_cast<size_t>(_deferred_size * ratio);
+    }
 
    private:
+    // Returns an uninitialized buffer of at least the given size, reusing a recycled one if possible.
+    buffer take_buffer(size_t size) {
+        for (auto it = _free_buffers.begin(); it != _free_buffers.end(); ++it) {
+            if (it->size() >= size) {
+                buffer b = std::move(*it);
+                *it = std::move(_free_buffers.back());
+                _free_buffers.pop_back();
+                return b;
+            }
+        }
+        return buffer{size};
+    }
+
+    seastar::future<> compress_deferred_page(size_t i) {
+        page_data& page = _pages[i];
+        if (!page.deferred) {
+            co_return;
+        }
+        buffer out = take_buffer(_compressor->max_compressed_size(page.size));
+        size_t compressed_size =
+          co_await _offload->compress(*_compressor, page.view(), std::span<byte>{out.data(), out.size()});
+        finish_deferred_page(i, std::move(out), compressed_size);
+    }
+
+    // Replaces the uncompressed contents of a deferred page with their compressed form in out.
+    void finish_deferred_page(size_t i, buffer out, size_t compressed_size) {
+        page_data& page = _pages[i];
+        _deferred_size -= page.size;
+        _estimated_chunk_size += compressed_size;
+        _uncompressed_size_seen += page.size;
+        _compressed_size_seen += compressed_size;
+        _free_buffers.push_back(std::exchange(page.storage, std::move(out)));
+        page.size = compressed_size;
+        page.deferred = false;
+        _page_headers[i].__set_compressed_page_size(compressed_size);
+    }
+
+    seastar::future<> compress_deferred_pages() {
+        if (!_offload) {
+            return seastar::make_ready_future<>();
+        }
+        using it = boost::counting_iterator<size_t>;
+        return seastar::parallel_for_each(it(0), it(_pages.size()),
+                                          [this](size_t i) { return compress_deferred_page(i); });
+    }
+
+    void recycle_pages() {
+        for (page_data& p : _pages) {
+            _free_buffers.push_back(std::move(p.storage));
+        }
+        _pages.clear();
+        if (_dict_page) {
+            _free_buffers.push_back(std::move(_dict_page->storage));
+            _dict_page.reset();
+        }
+    }
+
     void fill_dictionary_page() {
         bytes_view dict = *_val_encoder->view_dict();
-        _dict_page = _compressor->compress(dict);
+        buffer storage = take_buffer(_compressor->max_compressed_size(dict.size()));
+        size_t size = _compressor->compress(dict, std::span<byte>{storage.data(), storage.size()});
+        _dict_page = page_data{std::move(storage), size};
 
         format::DictionaryPageHeader dictionary_page_header;
         dictionary_page_header.__set_num_values(_val_encoder->cardinality());
@@ -266,7 +397,7 @@ class column_chunk_writer
         dictionary_page_header.__set_is_sorted(false);
         _dict_page_header.__set_type(format::PageType::DICTIONARY_PAGE);
         _dict_page_header.__set_uncompressed_page_size(dict.size());
-        _dict_page_header.__set_compressed_page_size(_dict_page.size());
+        _dict_page_header.__set_compressed_page_size(_dict_page->size);
         _dict_page_header.__set_dictionary_page_header(dictionary_page_header);
     }
 };
@@ -275,7 +406,8 @@ template <format::Type::type ParquetType>
 column_chunk_writer<ParquetType> make_column_chunk_writer(const writer_options& options) {
     return column_chunk_writer<ParquetType>(options.def_level, options.rep_level,
                                             make_value_encoder<ParquetType>(options.encoding),
-                                            compressor::make(options.compression));
+                                            compressor::make(options.compression, options.compression_options),
+                                            options.offload);
 }
 
 }  // namespace parquet4seastar
@@ -0,0 +1,207 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+
+#pragma once
+
+#include <parquet4seastar/file_reader.hh>
+#include <parquet4seastar/reader_schema.hh>
+#include <variant>
+
+namespace parquet4seastar {
+
+// One bit per slot, set for valid (non-null) slots. Least significant bit first, as in Arrow.
+class validity_bitmap
+{
+    std::vector<uint8_t> _bits;
+    size_t _size = 0;
+    size_t _null_count = 0;
+
+   public:
+    void push_back(bool valid) {
+        if (_size % 8 == 0) {
+            _bits.push_back(0);
+        }
+        _bits.back() |= static_cast<uint8_t>(valid) << (_size % 8);
+        _null_count += !valid;
+        ++_size;
+    }
+    // Append n slots given as one byte (0 or 1) per slot.
+    void append(const uint8_t valid[], size_t n) {
+        _bits.resize((_size + n + 7) / 8);
+        size_t set = 0;
+        for (size_t i = 0; i < n; ++i) {
+            _bits[(_size + i) / 8] |= valid[i] << ((_size + i) % 8);
+            set += valid[i];
+        }
+        _size += n;
+        _null_count += n - set;
+    }
+    // Append n slots, all valid or all null.
+    void append(size_t n, bool valid) {
+        const size_t end = _size + n;
+        _bits.resize((end + 7) / 8);
+        if (!valid) {
+            _null_count += n;
+        } else {
+            size_t i = _size;
+            for (; i < end && i % 8 != 0; ++i) {
+                _bits[i / 8] |= 1 << (i % 8);
+            }
+            if (i < end) {
+                // From a byte boundary on, the bytes are new, so they can be overwritten.
+                std::fill(_bits.begin() + i / 8, _bits.begin() + end / 8, 0xff);
+                if (end % 8 != 0) {
+                    _bits[end / 8] = (1 << (end % 8)) - 1;
+                }
+            }
+        }
+        _size = end;
+    }
+    // Make room for n more slots and return the bitmap, for them to be written directly from bit size() on.
+    // commit_append() has to follow.
+    uint8_t* prepare_append(size_t n) {
+        _bits.resize((_size + n + 7) / 8);
+        return _bits.data();
+    }
+    // Account for n slots written after prepare_append(), of which valid are valid.
+    void commit_append(size_t n, size_t valid) {
+        _size += n;
+        _null_count += n - valid;
+        _bits.resize((_size + 7) / 8);
+    }
+    bool operator[](size_t i) const { return _bits[i / 8] & (1 << (i % 8)); }
+    size_t size() const { return _size; }
+    size_t null_count() const { return _null_count; }
+    const uint8_t* data() const { return _bits.data(); }
+};
+
+/* The nesting of a leaf column, derived from the schema: one list level per repeated node on the path
+ * from the root to the leaf (including the leaf itself), outermost first.
+ * A list at level k exists when the definition level is at least lists[k - 1].def_level (0 for k = 0).
+ * Then, it is null below null_def_level, empty below def_level, and non-empty otherwise.
+ */
+struct column_shape
+{
+    struct list_level
+    {
+        uint32_t def_level;
+        uint32_t null_def_level;
+    };
+    std::vector<list_level> lists;
+    uint32_t max_def_level = 0;
+
+    static column_shape of(const reader_schema::raw_schema& schema, uint32_t column);
+    // The definition level at which a leaf slot exists.
+    uint32_t leaf_def_level() const { return lists.empty() ? 0 : lists.back().def_level; }
+    bool list_nullable(size_t k) const { return lists[k].null_def_level > (k == 0 ? 0 : lists[k - 1].def_level); }
+    bool leaf_nullable() const { return max_def_level > leaf_def_level(); }
+};
+
+// A list level of a column_batch, in the Arrow layout.
+struct list_batch
+{
+    // List i spans elements [offsets[i], offsets[i + 1]) of the next level.
+    std::vector<int32_t> offsets;
+    // Empty if the lists at this level can't be null.
+    validity_bitmap validity;
+};
+
+// A batch of rows of a single leaf column, in the Arrow layout.
+template <format::Type::type T>
+struct column_batch
+{
+    using output_type = typename value_decoder_traits<T>::output_type;
+    size_t rows = 0;
+    // One per repeated node, outermost first. The first level has one list per row.
+    std::vector<list_batch> lists;
+    // One slot per leaf value. Null slots hold default-constructed values.
+    std::vector<output_type> values;
+    // Empty if the leaf can't be null.
+    validity_bitmap validity;
+};
+
+/* Reads a column chunk in batches of rows, as contiguous arrays of values with validity bitmaps
+ * and list offsets, rather than value by value through record::record_reader.
+ */
+template <format::Type::type T>
+class column_batch_reader
+{
+   public:
+    using output_type = typename value_decoder_traits<T>::output_type;
+
+   private:
+    column_chunk_reader<T> _source;
+    column_shape _shape;
+    // Reused between batches.
+    std::vector<int16_t> _def;
+    std::vector<int16_t> _rep;
+    std::vector<output_type> _dense_values;
+    // One byte per list or slot, packed into a validity_bitmap at the end of a pass.
+    std::vector<uint8_t> _valid;
+
+    seastar::future<size_t> read_flat_optional(size_t n, column_batch<T>& batch);
+    void assemble_flat(column_batch<T>& batch);
+    void assemble_nested(column_batch<T>& batch);
+
+   public:
+    column_batch_reader(column_chunk_reader<T>&& source, column_shape shape);
+    // Read the next n rows (fewer at the end of the chunk).
+    seastar::future<column_batch<T>> read_batch(size_t n);
+};
+
+using any_column_batch =
+  std::variant<column_batch<format::Type::INT32>, column_batch<format::Type::INT64>, column_batch<format::Type::INT96>,
+               column_batch<format::Type::FLOAT>, column_batch<format::Type::DOUBLE>,
+               column_batch<format::Type::BOOLEAN>, column_batch<format::Type::BYTE_ARRAY>,
+               column_batch<format::Type::FIXED_LEN_BYTE_ARRAY>>;
+
+// Reads the projected leaf columns of a row group together, in batches of rows.
+class columnar_reader
+{
+    using any_column_batch_reader =
+      std::variant<column_batch_reader<format::Type::INT32>, column_batch_reader<format::Type::INT64>,
+                   column_batch_reader<format::Type::INT96>, column_batch_reader<format::Type::FLOAT>,
+                   column_batch_reader<format::Type::DOUBLE>, column_batch_reader<format::Type::BOOLEAN>,
+                   column_batch_reader<format::Type::BYTE_ARRAY>,
+                   column_batch_reader<format::Type::FIXED_LEN_BYTE_ARRAY>>;
+    std::vector<any_column_batch_reader> _readers;
+
+    explicit columnar_reader(std::vector<any_column_batch_reader> readers) : _readers{std::move(readers)} {}
+
+   public:
+    // The file_reader has to outlive the columnar_reader.
+    static seastar::future<columnar_reader> open(file_reader& file, uint32_t row_group, std::vector<uint32_t> columns);
+    // Read the next n rows (fewer at the end of the row group) of every projected column, in projection order.
+    // At the end of the row group, the batches have 0 rows.
+    seastar::future<std::vector<any_column_batch>> read_batch(size_t n);
+};
+
+extern template class column_batch_reader<format::Type::INT32>;
+extern template class column_batch_reader<format::Type::INT64>;
+extern template class column_batch_reader<format::Type::INT96>;
+extern template class column_batch_reader<format::Type::FLOAT>;
+extern template class column_batch_reader<format::Type::DOUBLE>;
+extern template class column_batch_reader<format::Type::BOOLEAN>;
+extern template class column_batch_reader<format::Type::BYTE_ARRAY>;
+extern template class column_batch_reader<format::Type::FIXED_LEN_BYTE_ARRAY>;
+
+}  // namespace parquet4seastar
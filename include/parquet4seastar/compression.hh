@@ -22,24 +22,46 @@
 #pragma once
 #include <cstdint>
 #include <cstddef>
+#include <optional>
+#include <span>
 #include <parquet4seastar/bytes.hh>
 #include <parquet4seastar/parquet_types.h>
 
 namespace parquet4seastar {
 
+// Codec-specific tuning. Unset fields fall back to the codec's defaults.
+// Codecs which don't support a given knob ignore it.
+struct compressor_options {
+    // Compression level (GZIP: -1 for the zlib default, or 0-9; BROTLI: quality 0-11).
+    std::optional<int> level;
+    // Base 2 logarithm of the sliding window size (BROTLI: 10-24).
+    std::optional<int> window_bits;
+};
+
 class compressor {
 public:
     // out has to be big enough to hold the uncompressed data.
     // Otherwise, an exception is thrown.
-    // We are always supposed to know the exact uncompressed size in Parquet.
-    virtual bytes decompress(bytes_view in, bytes&& out) const = 0;
+    // We are always supposed to know the exact uncompressed size in Parquet,
+    // so out can be a view of uninitialized memory. Returns the decompressed size.
+    virtual size_t decompress(bytes_view in, std::span<byte> out) const = 0;
+
+    // An upper bound of the compressed size of in_size bytes.
+    virtual size_t max_compressed_size(size_t in_size) const = 0;
+
+    // out has to be at least max_compressed_size(in.size()) bytes long.
+    // Otherwise, an exception may be thrown. Returns the compressed size.
+    virtual size_t compress(bytes_view in, std::span<byte> out) const = 0;
 
-    // out will be resized appropriately to hold the compressed data.
-    virtual bytes compress(bytes_view in, bytes&& out = bytes()) const = 0;
+    // Convenience wrappers of the above for callers which don't manage their own buffers.
+    // out is resized to the size of the result.
+    bytes decompress(bytes_view in, bytes&& out) const;
+    bytes compress(bytes_view in, bytes&& out = bytes()) const;
 
     virtual format::CompressionCodec::type type() const = 0;
 
-    static std::unique_ptr<compressor> make(format::CompressionCodec::type compression);
+    static std::unique_ptr<compressor> make(format::CompressionCodec::type compression,
+                                            const compressor_options& options = {});
 
     virtual ~compressor() = default;
 };
@@ -0,0 +1,95 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <parquet4seastar/compression.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/semaphore.hh>
+#include <thread>
+#include <vector>
+
+namespace seastar::alien {
+class instance;
+}
+
+namespace parquet4seastar {
+
+struct compression_offload_options
+{
+    // Pages of at least this many (uncompressed) bytes are (de)compressed on the worker threads.
+    // Smaller pages are cheaper to handle inline than to hand off.
+    size_t threshold = 256 * 1024;
+    size_t worker_threads = 1;
+    // The maximum number of pages submitted to the workers at once. Further submissions wait.
+    size_t max_queued = 16;
+};
+
+/* Compressing or decompressing a large GZIP or Brotli page can take milliseconds, which is long enough
+ * to stall the reactor. compression_offload runs such pages on a set of dedicated worker threads instead,
+ * and delivers the results back to the submitting shard as futures.
+ *
+ * An instance belongs to the shard which created it and must only be used from that shard.
+ * stop() has to be called (and waited for) before destruction.
+ */
+class compression_offload
+{
+    struct job
+    {
+        std::function<size_t()> work;
+        seastar::promise<size_t>* done;
+    };
+
+    compression_offload_options _options;
+    seastar::alien::instance& _alien;
+    unsigned _shard;
+    seastar::semaphore _queue_slots;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<job> _jobs;
+    bool _stopping = false;
+    std::vector<std::thread> _workers;
+
+    void worker_loop();
+    void join_workers();
+    seastar::future<size_t> submit(std::function<size_t()> work);
+
+   public:
+    explicit compression_offload(compression_offload_options options = {});
+    compression_offload(const compression_offload&) = delete;
+    ~compression_offload();
+
+    bool should_offload(size_t uncompressed_size) const { return uncompressed_size >= _options.threshold; }
+
+    // The same as compressor::decompress and compressor::compress, but run on a worker thread
+    // if the page is large enough. in and out have to stay alive until the returned future resolves.
+    seastar::future<size_t> decompress(const compressor& c, bytes_view in, std::span<byte> out);
+    seastar::future<size_t> compress(const compressor& c, bytes_view in, std::span<byte> out);
+
+    // Waits for submitted jobs to complete and shuts the worker threads down.
+    seastar::future<> stop();
+};
+
+}  // namespace parquet4seastar
@@ -28,6 +28,14 @@
 #include <parquet4seastar/rle_encoding.hh>
 #include <seastar/core/temporary_buffer.hh>
 #include <seastar/core/bitops.hh>
+#include <seastar/core/preempt.hh>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <variant>
 
 namespace parquet4seastar {
@@ -44,10 +52,17 @@ class level_decoder {
     uint32_t _bit_width;
     uint32_t _num_values;
     uint32_t _values_read;
+    // Set if all levels of the current page are known to be equal: when there are no levels at all
+    // (the max level is 0), or when the levels are a single RLE run. Then, _decoder is not used.
+    std::optional<uint32_t> _constant_level;
     uint32_t bit_width(uint32_t max_n) {
         return (max_n == 0) ? 0 : seastar::log2floor(max_n) + 1;
     }
 public:
+    // Where the levels of the current page come from.
+    enum class source : uint8_t { constant, rle, bit_packed };
+    static constexpr size_t source_count = 3;
+
     explicit level_decoder(uint32_t max_level) : _bit_width(bit_width(max_level)) {}
 
     // Set a new source of levels. V1 and V2 are for data pages V1 and V2 respectively.
@@ -61,8 +76,8 @@ public:
     template <typename T>
     uint32_t read_batch(uint32_t n, T out[]) {
         n = std::min(n, _num_values - _values_read);
-        if (_bit_width == 0) {
-            std::fill(out, out + n, 0);
+        if (_constant_level) {
+            std::fill(out, out + n, static_cast<T>(*_constant_level));
             _values_read += n;
             return n;
         }
@@ -79,6 +94,65 @@ public:
                 },
         }, _decoder);
     }
+    // Read a batch of n levels, like read_batch, fused with their validation and counting:
+    // adds the number of levels equal to level to *matches, and raises *max_level to the greatest level read.
+    // Runs of repeated levels are counted and checked once per run.
+    template <typename T>
+    uint32_t read_batch(uint32_t n, T out[], uint32_t level, uint32_t* matches, uint64_t* max_level) {
+        switch (current_source()) {
+            case source::constant:
+                return read_batch_from<source::constant>(n, out, level, matches, max_level);
+            case source::rle:
+                return read_batch_from<source::rle>(n, out, level, matches, max_level);
+            default:
+                return read_batch_from<source::bit_packed>(n, out, level, matches, max_level);
+        }
+    }
+    // The same as above, for callers which already know the source of the current page (see current_source()).
+    // Compiles to the loop of that source alone.
+    template <source S, typename T>
+    uint32_t read_batch_from(uint32_t n, T out[], uint32_t level, uint32_t* matches, uint64_t* max_level) {
+        assert(current_source() == S);
+        n = std::min(n, _num_values - _values_read);
+        uint32_t n_read;
+        if constexpr (S == source::constant) {
+            std::fill(out, out + n, static_cast<T>(*_constant_level));
+            *matches += (*_constant_level == level) * n;
+            *max_level = std::max<uint64_t>(*max_level, *_constant_level);
+            n_read = n;
+        } else if constexpr (S == source::rle) {
+            n_read = std::get<RleDecoder>(_decoder).GetBatchWithStats(out, n, static_cast<T>(level), matches,
+                                                                      max_level);
+        } else {
+            n_read = std::get<BitReader>(_decoder).GetBatch(_bit_width, out, n);
+            uint32_t batch_matches = 0;
+            T batch_max = 0;
+            for (size_t i = 0; i < n_read; ++i) {
+                batch_matches += out[i] == static_cast<T>(level);
+                batch_max = std::max(batch_max, out[i]);
+            }
+            *matches += batch_matches;
+            *max_level = std::max(*max_level, static_cast<uint64_t>(batch_max));
+        }
+        _values_read += n_read;
+        return n_read;
+    }
+    // Read a batch of n levels of bit width 1 (a max level of 1) as a bitmap: a bit is set for level 1.
+    // Adds the number of levels equal to 1 to *set_count and raises *max_level as above.
+    uint32_t read_bitmap(uint32_t n, BitmapWriter& out, uint32_t* set_count, uint64_t* max_level);
+    // Skip n levels (fewer at the end of data). Runs of repeated levels are skipped without decoding.
+    // If matches is given, the number of skipped levels equal to level is added to it.
+    uint32_t skip(uint32_t n, uint32_t level = 0, uint32_t* matches = nullptr);
+    // The number of levels left in the current page.
+    uint32_t levels_left() const { return _num_values - _values_read; }
+    // The level of all levels in the current page, if they are known to be all equal.
+    std::optional<uint32_t> constant_level() const { return _constant_level; }
+    source current_source() const {
+        if (_constant_level) {
+            return source::constant;
+        }
+        return std::holds_alternative<RleDecoder>(_decoder) ? source::rle : source::bit_packed;
+    }
 };
 
 template<format::Type::type T>
@@ -127,6 +201,131 @@ template<> struct value_decoder_traits<format::Type::FIXED_LEN_BYTE_ARRAY> {
     using input_type = std::basic_string_view<uint8_t>;
 };
 
+// An allocator which default-initializes instead of value-initializing, so that resizing a vector
+// of bytes leaves the new bytes uninitialized, to be overwritten by the caller.
+template<typename T>
+struct default_init_allocator : std::allocator<T> {
+    template<typename U>
+    struct rebind {
+        using other = default_init_allocator<U>;
+    };
+    using std::allocator<T>::allocator;
+    template<typename U>
+    void construct(U* p) noexcept(std::is_nothrow_default_constructible_v<U>) {
+        ::new (static_cast<void*>(p)) U;
+    }
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+/* Byte arrays stored back to back in a single buffer, as in the Arrow binary (OffsetT = int32_t)
+ * and large binary (OffsetT = int64_t) layouts. Value i spans data()[offsets()[i], offsets()[i + 1]).
+ * Compared to a temporary_buffer per value, this saves an object and a refcount per value,
+ * and keeps the values adjacent in memory.
+ */
+template<typename OffsetT>
+class byte_array_arena {
+    static_assert(std::is_same_v<OffsetT, int32_t> || std::is_same_v<OffsetT, int64_t>);
+public:
+    using data_vector = std::vector<uint8_t, default_init_allocator<uint8_t>>;
+private:
+    std::vector<OffsetT> _offsets{0};
+    data_vector _data;
+    void check_size(size_t extra) const {
+        if (_data.size() + extra > static_cast<size_t>(std::numeric_limits<OffsetT>::max())) {
+            throw parquet_exception(seastar::format(
+                    "byte_array_arena with {}-bit offsets overflowed", std::numeric_limits<OffsetT>::digits + 1));
+        }
+    }
+public:
+    size_t size() const { return _offsets.size() - 1; }
+    bool empty() const { return size() == 0; }
+    bytes_view operator[](size_t i) const {
+        return {_data.data() + _offsets[i], static_cast<size_t>(_offsets[i + 1] - _offsets[i])};
+    }
+    const std::vector<OffsetT>& offsets() const { return _offsets; }
+    const data_vector& data() const { return _data; }
+    // Make room for n more bytes of data, so that the following appends don't reallocate.
+    void reserve_data(size_t n) { _data.reserve(_data.size() + n); }
+    void push_back(bytes_view value) {
+        check_size(value.size());
+        _data.insert(_data.end(), value.begin(), value.end());
+        _offsets.push_back(static_cast<OffsetT>(_data.size()));
+    }
+    // Append n values of lengths[i] (>= 0) bytes each. Return where their data is to be written, back to back.
+    uint8_t* append_uninitialized(const int32_t lengths[], size_t n) {
+        size_t total_size = 0;
+        for (size_t i = 0; i < n; ++i) {
+            total_size += lengths[i];
+        }
+        // Check before any offset is pushed, so that an overflow leaves the arena as it was.
+        check_size(total_size);
+        size_t data_size = _data.size();
+        size_t offset = data_size;
+        _offsets.reserve(_offsets.size() + n);
+        for (size_t i = 0; i < n; ++i) {
+            offset += lengths[i];
+            _offsets.push_back(static_cast<OffsetT>(offset));
+        }
+        _data.resize(data_size + total_size);
+        return _data.data() + data_size;
+    }
+    // Append n values which are already back to back in data. Value i is lengths[i] (>= 0) bytes long.
+    void append(const uint8_t* data, const int32_t lengths[], size_t n) {
+        size_t data_size = _data.size();
+        uint8_t* out = append_uninitialized(lengths, n);
+        if (_data.size() > data_size) {
+            std::memcpy(out, data, _data.size() - data_size);
+        }
+    }
+    // Append values[indices[0]], ..., values[indices[n - 1]]. The data grows once for all of them.
+    void append_indexed(const bytes_view values[], const uint32_t indices[], size_t n) {
+        size_t total_size = 0;
+        for (size_t i = 0; i < n; ++i) {
+            total_size += values[indices[i]].size();
+        }
+        check_size(total_size);
+        size_t data_size = _data.size();
+        size_t offset = data_size;
+        _offsets.reserve(_offsets.size() + n);
+        for (size_t i = 0; i < n; ++i) {
+            offset += values[indices[i]].size();
+            _offsets.push_back(static_cast<OffsetT>(offset));
+        }
+        _data.resize(data_size + total_size);
+        uint8_t* out = _data.data() + data_size;
+        for (size_t i = 0; i < n; ++i) {
+            bytes_view value = values[indices[i]];
+            std::memcpy(out, value.data(), value.size());
+            out += value.size();
+        }
+    }
+    void clear() {
+        _offsets.resize(1);
+        _data.clear();
+    }
+};
+
+template<typename T>
+constexpr bool is_byte_array_arena_v = false;
+template<typename OffsetT>
+constexpr bool is_byte_array_arena_v<byte_array_arena<OffsetT>> = true;
+
+/* A caller's buffer which receives FIXED_LEN_BYTE_ARRAY values back to back, type_length bytes each,
+ * instead of a temporary_buffer per value. It has to have room for all the values read into it.
+ */
+struct fixed_len_buffer {
+    uint8_t* data;
+    // The number of values written so far.
+    size_t size = 0;
+};
+
+// Convert n DECIMAL values, stored as big-endian two's complement integers of width bytes each
+// (FIXED_LEN_BYTE_ARRAY), to native integers. width has to be between 1 and 16.
+void decode_decimals(const uint8_t in[], size_t width, size_t n, __int128 out[]);
+
 /* Refer to the parquet documentation for the description of supported encodings:
  * https://github.com/apache/parquet-format/blob/master/Encodings.md
  * doc/parquet/Encodings.md
@@ -143,35 +342,119 @@ public:
     virtual void reset(bytes_view buf) = 0;
     // Read a batch of n values (the last batch may be smaller than n).
     virtual size_t read_batch(size_t n, output_type out[]) = 0;
+    // Skip n values (fewer at the end of data). Decoders which can skip without decoding override this.
+    virtual size_t skip(size_t n) {
+        std::array<output_type, 64> scratch;
+        size_t n_skipped = 0;
+        while (n_skipped < n) {
+            size_t n_read = read_batch(std::min(n - n_skipped, scratch.size()), scratch.data());
+            if (n_read == 0) {
+                break;
+            }
+            n_skipped += n_read;
+        }
+        return n_skipped;
+    }
+    // Read a batch of n values (the last batch may be smaller than n), appending them to out.
+    // Byte array decoders which can fill out without a temporary_buffer per value override these.
+    virtual size_t read_contiguous(size_t n, byte_array_arena<int32_t>& out) {
+        return read_contiguous_by_value(n, out);
+    }
+    virtual size_t read_contiguous(size_t n, byte_array_arena<int64_t>& out) {
+        return read_contiguous_by_value(n, out);
+    }
+    // Read a batch of n fixed length values (the last batch may be smaller than n) into out, back to back.
+    virtual size_t read_fixed(size_t n, uint8_t out[]) {
+        if constexpr (std::is_same_v<output_type, seastar::temporary_buffer<uint8_t>>) {
+            std::array<output_type, 64> scratch;
+            size_t completed = 0;
+            while (completed < n) {
+                size_t n_read = read_batch(std::min(n - completed, scratch.size()), scratch.data());
+                if (n_read == 0) {
+                    break;
+                }
+                for (size_t i = 0; i < n_read; ++i) {
+                    std::memcpy(out, scratch[i].get(), scratch[i].size());
+                    out += scratch[i].size();
+                }
+                completed += n_read;
+            }
+            return completed;
+        } else {
+            throw parquet_exception("Fixed length output is only supported for byte arrays");
+        }
+    }
     virtual ~decoder() = default;
+protected:
+    template<typename OffsetT>
+    size_t read_contiguous_by_value(size_t n, byte_array_arena<OffsetT>& out) {
+        if constexpr (std::is_same_v<output_type, seastar::temporary_buffer<uint8_t>>) {
+            std::array<output_type, 64> scratch;
+            size_t completed = 0;
+            while (completed < n) {
+                size_t n_read = read_batch(std::min(n - completed, scratch.size()), scratch.data());
+                if (n_read == 0) {
+                    break;
+                }
+                for (size_t i = 0; i < n_read; ++i) {
+                    out.push_back(bytes_view(scratch[i].get(), scratch[i].size()));
+                }
+                completed += n_read;
+            }
+            return completed;
+        } else {
+            throw parquet_exception("Contiguous output is only supported for byte arrays");
+        }
+    }
 };
 
-// A uniform interface to all the various value decoders.
+/* A uniform interface to all the various value decoders.
+ * The decoders of all encodings valid for ParquetType are alternatives of a variant, which is allocated once
+ * and reset in place on every page. A page of the same encoding as the previous one reuses its decoder
+ * along with its buffers, and calls are dispatched statically to the final decoder classes.
+ */
 template<format::Type::type ParquetType>
 class value_decoder {
 public:
     using output_type = typename value_decoder_traits<ParquetType>::output_type;
 private:
-    std::unique_ptr<decoder<ParquetType>> _decoder;
+    struct decoders;
+    std::unique_ptr<decoders> _decoders;
     std::optional<uint32_t> _type_length;
     bool _dict_set = false;
+    bool _dictionary_encoded = false;
+    bool _plain_encoded = false;
     output_type* _dict = nullptr;
     size_t _dict_size = 0;
 public:
-    value_decoder(std::optional<uint32_t>(type_length))
-            : _type_length(type_length) {
-        if constexpr (ParquetType == format::Type::FIXED_LEN_BYTE_ARRAY) {
-            if (!_type_length) {
-                throw parquet_exception::corrupted_file("type_length not set for FIXED_LEN_BYTE_ARRAY");
-            }
-        }
-    }
+    value_decoder(std::optional<uint32_t> type_length);
+    value_decoder(value_decoder&&) noexcept;
+    value_decoder& operator=(value_decoder&&) noexcept;
+    ~value_decoder();
     // Set a new dictionary (to be used for decoding RLE_DICTIONARY) for this reader.
     void reset_dict(output_type* dictionary, size_t dictionary_size);
     // Set a new source of encoded data.
     void reset(bytes_view buf, format::Encoding::type encoding);
     // Read a batch of n values (the last batch may be smaller than n).
     size_t read_batch(size_t n, output_type out[]);
+    // Skip n values (fewer at the end of data).
+    size_t skip(size_t n);
+    // Read a batch of n byte arrays (the last batch may be smaller than n), appending them to out.
+    size_t read_batch(size_t n, byte_array_arena<int32_t>& out);
+    size_t read_batch(size_t n, byte_array_arena<int64_t>& out);
+    // Read a batch of n FIXED_LEN_BYTE_ARRAY values (the last batch may be smaller than n), appending them to out.
+    size_t read_batch(size_t n, fixed_len_buffer& out);
+    // Whether the current data is dictionary-encoded.
+    bool dictionary_encoded() const { return _dictionary_encoded; }
+    // Whether the current data is PLAIN-encoded.
+    bool plain_encoded() const { return _plain_encoded; }
+    // The same as read_batch, for callers which already know the encoding of the current data.
+    // They call the PLAIN and dictionary decoders directly, rather than through a visit of all decoders.
+    size_t read_plain(size_t n, output_type out[]);
+    size_t read_dictionary(size_t n, output_type out[]);
+    // Read a batch of n dictionary indices, without looking them up (the last batch may be smaller than n).
+    // Only valid if dictionary_encoded().
+    size_t read_indices(size_t n, uint32_t out[]);
 };
 
 extern template class value_decoder<format::Type::INT32>;
@@ -183,8 +466,23 @@ extern template class value_decoder<format::Type::BOOLEAN>;
 extern template class value_decoder<format::Type::BYTE_ARRAY>;
 extern template class value_decoder<format::Type::FIXED_LEN_BYTE_ARRAY>;
 
+/* Encoding is synchronous, so long encoding loops can't yield by themselves.
+ * Instead, they call the yield hook when the task quota runs out. The hook is supplied by the user,
+ * e.g. seastar::thread::yield when writing from a seastar::thread.
+ */
+using yield_hook = std::function<void()>;
+
 template <format::Type::type ParquetType>
 class value_encoder {
+protected:
+    yield_hook _yield_hook;
+    // The number of values encoded between checks for preemption.
+    static constexpr size_t PREEMPTION_CHECK_INTERVAL = 4096;
+    void maybe_yield() {
+        if (_yield_hook && seastar::need_preempt()) {
+            _yield_hook();
+        }
+    }
 public:
     struct flush_result {
         size_t size;
@@ -196,6 +494,7 @@ public:
     virtual flush_result flush(byte sink[]) = 0;
     virtual std::optional<bytes_view> view_dict() { return {}; };
     virtual uint64_t cardinality() { return 0; }
+    virtual void set_yield_hook(yield_hook hook) { _yield_hook = std::move(hook); }
     virtual ~value_encoder() = default;
 };
 
@@ -82,6 +82,8 @@ class file_reader
     std::unique_ptr<format::FileMetaData> _metadata = nullptr;
     std::unique_ptr<reader_schema::schema> _schema = nullptr;
     std::unique_ptr<reader_schema::raw_schema> _raw_schema = nullptr;
+    compression_offload* _offload = nullptr;
+    reader_memory_limiter* _memory_limiter = nullptr;
 
     static seastar::future<std::unique_ptr<format::FileMetaData>> read_file_metadata(IReader& file);
     template <format::Type::type T>
@@ -106,6 +108,14 @@ class file_reader
     }
 
     const format::FileMetaData& metadata() const { return *_metadata; }
+
+    // Decompress large pages of subsequently opened column chunks on the worker threads of offload.
+    // offload has to outlive the column chunk readers.
+    void set_compression_offload(compression_offload* offload) { _offload = offload; }
+    // Charge the buffers of subsequently opened column chunks against the limiter.
+    // The limiter has to outlive the column chunk readers.
+    void set_memory_limiter(reader_memory_limiter* limiter) { _memory_limiter = limiter; }
+
     // The schemata are computed lazily (not on open) for robustness.
     // This way lower-level operations (i.e. inspecting metadata,
     // reading raw data with column_chunk_reader) can be done even if
@@ -57,6 +57,7 @@ class writer
     std::vector<std::vector<std::string>> _leaf_paths;
     thrift_serializer _thrift_serializer;
     size_t _file_offset = 0;
+    compression_offload* _offload = nullptr;
 
    private:
     void init_writers(const writer_schema::schema& root) {
@@ -81,7 +82,8 @@ class writer
                                  },
                                  [&](auto logical_type) {
                                      constexpr format::Type::type parquet_type = decltype(logical_type)::physical_type;
-                                     writer_options options = {def + x.optional, rep, x.encoding, x.compression};
+                                     writer_options options = {def + x.optional, rep, x.encoding, x.compression,
+                                                               x.compression_options, _offload};
                                      _writers.push_back(make_column_chunk_writer<parquet_type>(options));
                                  }},
                                x.logical_type);
@@ -101,9 +103,12 @@ class writer
         return std::move(_sink);
     }
 
+    // If offload is given, large pages are compressed on its worker threads. It has to outlive the writer.
     static seastar::future<std::unique_ptr<writer>> open_and_write_par1(SINK&& sink,
-                                                                        const writer_schema::schema& schema) {
+                                                                        const writer_schema::schema& schema,
+                                                                        compression_offload* offload = nullptr) {
         auto fw = std::make_unique<writer>(std::move(sink));
+        fw->_offload = offload;
         writer_schema::write_schema_result wsr = writer_schema::write_schema(schema);
         fw->_metadata.schema = std::move(wsr.elements);
         fw->_leaf_paths = std::move(wsr.leaf_paths);
@@ -113,8 +118,10 @@ class writer
         co_return fw;
     }
 
-    static seastar::future<std::unique_ptr<writer>> open(SINK&& sink, const writer_schema::schema& schema) {
-        return seastar::futurize_invoke([&schema, &sink] { return open_and_write_par1(std::move(sink), schema); });
+    static seastar::future<std::unique_ptr<writer>> open(SINK&& sink, const writer_schema::schema& schema,
+                                                         compression_offload* offload = nullptr) {
+        return seastar::futurize_invoke(
+          [&schema, &sink, offload] { return open_and_write_par1(std::move(sink), schema, offload); });
     }
 
     template <format::Type::type ParquetType>
@@ -122,6 +129,13 @@ class writer
         return std::get<column_chunk_writer<ParquetType>>(_writers[i]);
     }
 
+    // Called from long-running encoding loops of all columns when the task quota runs out.
+    void set_yield_hook(yield_hook hook) {
+        for (auto& writer : _writers) {
+            std::visit([&](auto& x) { x.set_yield_hook(hook); }, writer);
+        }
+    }
+
     auto flush_page(int idx, uint64_t limit_size) -> bool {
         return std::visit(
           [&limit_size](auto& col) -> bool {
@@ -244,7 +258,8 @@ class sync_writer
                                  },
                                  [&](auto logical_type) {
                                      constexpr format::Type::type parquet_type = decltype(logical_type)::physical_type;
-                                     writer_options options = {def + x.optional, rep, x.encoding, x.compression};
+                                     writer_options options = {def + x.optional, rep, x.encoding, x.compression,
+                                                               x.compression_options};
                                      _writers.push_back(make_column_chunk_writer<parquet_type>(options));
                                  }},
                                x.logical_type);
@@ -284,6 +299,13 @@ class sync_writer
         return std::get<column_chunk_writer<ParquetType>>(_writers[i]);
     }
 
+    // Called from long-running encoding loops of all columns when the task quota runs out.
+    void set_yield_hook(yield_hook hook) {
+        for (auto& writer : _writers) {
+            std::visit([&](auto& x) { x.set_yield_hook(hook); }, writer);
+        }
+    }
+
     auto flush_page(int idx, uint64_t limit_size) -> bool {
         return std::visit(
           [&limit_size](auto& col) -> bool {
@@ -0,0 +1,75 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#pragma once
+
+#include <seastar/core/future.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/semaphore.hh>
+#include <string>
+
+namespace parquet4seastar {
+
+using reader_memory_units = seastar::semaphore_units<>;
+
+/* A shard-wide budget for the memory held by readers: stream buffers, decompression buffers
+ * and dictionaries. Readers wait for units before growing any of those, so that many concurrent scans
+ * can't run the shard out of memory.
+ *
+ * Create one per shard and attach it to file readers with file_reader::set_memory_limiter().
+ * A single reader holds several buffers at once, so the budget should be at least a few times bigger
+ * than the biggest pages and dictionaries. A single request bigger than the whole budget is clamped to it.
+ *
+ * The memory in use is exported as the parquet4seastar_reader_memory_used_bytes metric.
+ */
+class reader_memory_limiter
+{
+    size_t _limit;
+    seastar::semaphore _units;
+    seastar::metrics::metric_groups _metrics;
+
+   public:
+    explicit reader_memory_limiter(size_t limit);
+    reader_memory_limiter(const reader_memory_limiter&) = delete;
+
+    seastar::future<reader_memory_units> reserve(size_t bytes);
+    size_t limit() const { return _limit; }
+    size_t used() const { return _limit - _units.available_units(); }
+    size_t waiters() const { return _units.waiters(); }
+};
+
+// The memory charged for a single buffer. Waits for units before the buffer grows.
+// Without a limiter, nothing is charged.
+class reader_memory_charge
+{
+    reader_memory_limiter* _limiter = nullptr;
+    reader_memory_units _units;
+
+   public:
+    reader_memory_charge() = default;
+    explicit reader_memory_charge(reader_memory_limiter* limiter) : _limiter{limiter} {}
+
+    // Adjust the charge to the given size.
+    seastar::future<> resize(size_t size);
+    void release() { _units.return_all(); }
+};
+
+}  // namespace parquet4seastar
@@ -31,6 +31,58 @@ namespace parquet4seastar::record {
 
 struct field_reader;
 
+/* The levels buffered by a column reader. Nearly all schemas have levels under 256, so levels are stored
+ * in bytes when they fit, and in int16_t otherwise. That is 4x less memory traffic than int32_t levels.
+ * The def and rep levels of a reader must share a width, since they are read together,
+ * so the width is chosen by the greater of the two maximum levels.
+ */
+class level_buffer {
+    std::vector<uint8_t> _narrow;
+    std::vector<int16_t> _wide;
+    bool _is_wide;
+public:
+    level_buffer(uint32_t max_level, size_t size)
+        : _is_wide{max_level > std::numeric_limits<uint8_t>::max()} {
+        resize(size);
+    }
+    bool wide() const { return _is_wide; }
+    size_t size() const { return _is_wide ? _wide.size() : _narrow.size(); }
+    void resize(size_t n) { _is_wide ? _wide.resize(n) : _narrow.resize(n); }
+    int operator[](size_t i) const { return _is_wide ? _wide[i] : _narrow[i]; }
+    template <typename LevelT>
+    LevelT* data() {
+        if constexpr (std::is_same_v<LevelT, int16_t>) {
+            return _wide.data();
+        } else {
+            static_assert(std::is_same_v<LevelT, uint8_t>);
+            return _narrow.data();
+        }
+    }
+    // Move the levels [from, to) to the front.
+    void move_to_front(size_t from, size_t to) {
+        if (_is_wide) {
+            std::copy(_wide.begin() + from, _wide.begin() + to, _wide.begin());
+        } else {
+            std::copy(_narrow.begin() + from, _narrow.begin() + to, _narrow.begin());
+        }
+    }
+    // The number of levels in [from, to) equal to level.
+    size_t count(size_t from, size_t to, int level) const {
+        return _is_wide ? std::count(_wide.begin() + from, _wide.begin() + to, level)
+                        : std::count(_narrow.begin() + from, _narrow.begin() + to, level);
+    }
+    // The position of the first level in [from, to) equal to level, or to if there is none.
+    size_t find(size_t from, size_t to, int level) const {
+        return _is_wide ? std::find(_wide.begin() + from, _wide.begin() + to, level) - _wide.begin()
+                        : std::find(_narrow.begin() + from, _narrow.begin() + to, level) - _narrow.begin();
+    }
+};
+
+/* Record assembly is split in two steps. fill_record() reads, asynchronously, until every leaf column
+ * has the whole current record buffered. Then, the record is assembled by plain synchronous calls
+ * (read_field, skip_field, current_levels). When whole records are already buffered, which is the common case,
+ * no future is involved at all: the continuation machinery would cost more than the decoding itself.
+ */
 template <typename LogicalType>
 class typed_primitive_reader {
 public:
@@ -42,19 +94,16 @@ private:
     uint32_t _rep_level;
     std::string _name;
     LogicalType _logical_type;
-    std::vector<int32_t> _rep_levels;
-    std::vector<int32_t> _def_levels;
+    level_buffer _rep_levels;
+    level_buffer _def_levels;
     std::vector<output_type> _values;
     size_t _levels_offset = 0;
     size_t _values_offset = 0;
     size_t _levels_buffered = 0;
     size_t _values_buffered = 0;
-
-    struct triplet {
-        int16_t def_level;
-        int16_t rep_level;
-        std::optional<output_type> value;
-    };
+    // Where the record after the current one begins, if it is buffered. Only for repeated columns.
+    size_t _next_record = 0;
+    bool _eof = false;
 public:
     explicit typed_primitive_reader(
             const reader_schema::primitive_node& node,
@@ -65,8 +114,8 @@ public:
         , _rep_level{node.rep_level}
         , _name{node.info.name}
         , _logical_type(std::get<LogicalType>(node.logical_type))
-        , _rep_levels(batch_size)
-        , _def_levels(batch_size)
+        , _rep_levels(std::max(_def_level, _rep_level), batch_size)
+        , _def_levels(std::max(_def_level, _rep_level), batch_size)
         , _values(batch_size) {
         if (_def_level > static_cast<uint32_t>(std::numeric_limits<int16_t>::max())
                 || _rep_level > static_cast<uint32_t>(std::numeric_limits<int16_t>::max())) {
@@ -76,16 +125,19 @@ public:
     }
 
     template <typename Consumer>
-    seastar::future<> read_field(Consumer& c);
-    seastar::future<> skip_field();
-    seastar::future<std::pair<int, int>> current_levels();
+    void read_field(Consumer& c);
+    void skip_field();
+    std::pair<int, int> current_levels();
+    // Whether the whole current record is buffered (false at the end of data).
+    bool record_buffered();
+    seastar::future<> fill_record();
     const std::string& name() const { return _name; };
 
 private:
     int current_def_level();
     int current_rep_level();
-    seastar::future<> refill_when_empty();
-    seastar::future<std::optional<triplet>> next();
+    template <typename LevelT>
+    seastar::future<size_t> read_levels(size_t levels_offset, size_t values_offset);
 };
 
 class struct_reader {
@@ -99,9 +151,11 @@ public:
             std::vector<field_reader>&& readers);
 
     template <typename Consumer>
-    seastar::future<> read_field(Consumer& c);
-    seastar::future<> skip_field();
-    seastar::future<std::pair<int, int>> current_levels();
+    void read_field(Consumer& c);
+    void skip_field();
+    std::pair<int, int> current_levels();
+    bool record_buffered();
+    seastar::future<> fill_record();
     const std::string& name() const { return _name; };
 };
 
@@ -116,9 +170,11 @@ public:
             std::unique_ptr<field_reader> reader);
 
     template <typename Consumer>
-    seastar::future<> read_field(Consumer& c);
-    seastar::future<> skip_field();
-    seastar::future<std::pair<int, int>> current_levels();
+    void read_field(Consumer& c);
+    void skip_field();
+    std::pair<int, int> current_levels();
+    bool record_buffered();
+    seastar::future<> fill_record();
     const std::string& name() const { return _name; };
 };
 
@@ -133,9 +189,11 @@ public:
             std::unique_ptr<field_reader> reader);
 
     template <typename Consumer>
-    seastar::future<> read_field(Consumer& c);
-    seastar::future<> skip_field();
-    seastar::future<std::pair<int, int>> current_levels();
+    void read_field(Consumer& c);
+    void skip_field();
+    std::pair<int, int> current_levels();
+    bool record_buffered();
+    seastar::future<> fill_record();
     const std::string& name() const { return _name; };
 };
 
@@ -152,13 +210,15 @@ public:
             std::unique_ptr<field_reader> value_reader);
 
     template <typename Consumer>
-    seastar::future<> read_field(Consumer& c);
-    seastar::future<> skip_field();
-    seastar::future<std::pair<int, int>> current_levels();
+    void read_field(Consumer& c);
+    void skip_field();
+    std::pair<int, int> current_levels();
+    bool record_buffered();
+    seastar::future<> fill_record();
     const std::string& name() const { return _name; };
 private:
     template <typename Consumer>
-    seastar::future<> read_pair(Consumer& c);
+    void read_pair(Consumer& c);
 };
 
 struct field_reader {
@@ -202,15 +262,21 @@ struct field_reader {
         return *std::visit([](const auto& x) {return &x.name();}, _reader);
     }
     template <typename Consumer>
-    seastar::future<> read_field(Consumer& c) {
-        return std::visit([&](auto& x) {return x.read_field(c);}, _reader);
+    void read_field(Consumer& c) {
+        std::visit([&](auto& x) {x.read_field(c);}, _reader);
     }
-    seastar::future<> skip_field() {
-        return std::visit([](auto& x) {return x.skip_field();}, _reader);
+    void skip_field() {
+        std::visit([](auto& x) {x.skip_field();}, _reader);
     }
-    seastar::future<std::pair<int, int>> current_levels() {
+    std::pair<int, int> current_levels() {
         return std::visit([](auto& x) {return x.current_levels();}, _reader);
     }
+    bool record_buffered() {
+        return std::visit([](auto& x) {return x.record_buffered();}, _reader);
+    }
+    seastar::future<> fill_record() {
+        return std::visit([](auto& x) {return x.fill_record();}, _reader);
+    }
     static seastar::future<field_reader>
     make(file_reader& file, const reader_schema::node& node_variant, int row_group);
 };
@@ -223,6 +289,9 @@ class record_reader {
             std::vector<field_reader>&& field_readers)
         : _schema(schema), _field_readers(std::move(field_readers)) {
     }
+    bool record_buffered();
+    seastar::future<> fill_record();
+    template <typename Consumer> void read_buffered(Consumer& c);
 public:
     template <typename Consumer> seastar::future<> read_one(Consumer& c);
     template <typename Consumer> seastar::future<> read_all(Consumer& c);
@@ -232,171 +301,205 @@ public:
 
 template <typename L>
 template <typename Consumer>
-inline seastar::future<> typed_primitive_reader<L>::read_field(Consumer& c) {
-    return next().then([this, &c] (std::optional<triplet> t) {
-        if (!t) {
-            throw parquet_exception("No more values buffered");
-        } else if (t->value) {
-            c.append_value(_logical_type, std::move(*t->value));
-        }
-    });
+inline void typed_primitive_reader<L>::read_field(Consumer& c) {
+    if (_levels_offset == _levels_buffered) {
+        throw parquet_exception("No more values buffered");
+    }
+    int def_level = current_def_level();
+    _levels_offset++;
+    if (def_level < static_cast<int>(_def_level)) {
+        return;
+    }
+    if (_values_offset == _values_buffered) {
+        throw parquet_exception("Value was non-null, but has not been buffered");
+    }
+    c.append_value(_logical_type, std::move(_values[_values_offset++]));
 }
 
 template <typename Consumer>
-inline seastar::future<> struct_reader::read_field(Consumer& c) {
+inline void struct_reader::read_field(Consumer& c) {
     c.start_struct();
-    return seastar::do_for_each(_readers, [&c] (auto& child) mutable {
+    for (field_reader& child : _readers) {
         c.start_field(child.name());
-        return child.read_field(c);
-    }).then([&c] {
-        c.end_struct();
-    });
+        child.read_field(c);
+    }
+    c.end_struct();
 }
 
 template <typename Consumer>
-inline seastar::future<> list_reader::read_field(Consumer& c) {
+inline void list_reader::read_field(Consumer& c) {
     c.start_list();
-    return current_levels().then([this, &c] ( std::pair<int,int >  level) {
-        auto def = level.first;
-        if (def > static_cast<int>(_def_level)) {
-            return _reader->read_field(c).then([this, &c] {
-                return seastar::repeat([this, &c] {
-                    return current_levels().then([this, &c] (std::pair<int,int> level) {
-                        auto [def,rep] = level;
-                        if (rep > static_cast<int>(_rep_level)) {
-                            c.separate_list_values();
-                            return _reader->read_field(c).then([] {
-                                return seastar::stop_iteration::no;
-                            });
-                        } else {
-                            return seastar::make_ready_future<seastar::stop_iteration>(seastar::stop_iteration::yes);
-                        }
-                    });
-                });
-            });
-        } else {
-            return _reader->skip_field();
+    auto [def, rep] = current_levels();
+    if (def > static_cast<int>(_def_level)) {
+        _reader->read_field(c);
+        while (true) {
+            auto [def, rep] = current_levels();
+            if (rep <= static_cast<int>(_rep_level)) {
+                break;
+            }
+            c.separate_list_values();
+            _reader->read_field(c);
         }
-    }).then([&c] {
-        c.end_list();
-    });
+    } else {
+        _reader->skip_field();
+    }
+    c.end_list();
 }
 
 template <typename Consumer>
-inline seastar::future<> optional_reader::read_field(Consumer& c) {
-    return current_levels().then([this, &c] (std::pair<int,int> level) {
-        auto def = level.first;
-        if (def > static_cast<int>(_def_level)) {
-            return _reader->read_field(c);
-        } else {
-            c.append_null();
-            return _reader->skip_field();
-        }
-    });
+inline void optional_reader::read_field(Consumer& c) {
+    auto [def, rep] = current_levels();
+    if (def > static_cast<int>(_def_level)) {
+        _reader->read_field(c);
+    } else {
+        c.append_null();
+        _reader->skip_field();
+    }
 }
 
 template <typename Consumer>
-inline seastar::future<> map_reader::read_field(Consumer& c) {
+inline void map_reader::read_field(Consumer& c) {
     c.start_map();
-    return current_levels().then([this, &c] (std::pair<int,int> level) {
-        auto def = level.first;
-        if (def > static_cast<int>(_def_level)) {
-            return read_pair<Consumer>(c).then([this, &c] {
-                return seastar::repeat([this, &c] {
-                    return current_levels().then([this, &c] (std::pair<int,int> level) {
-                        auto [def, rep] = level;
-                        if (rep > static_cast<int>(_rep_level)) {
-                            c.separate_map_values();
-                            return read_pair<Consumer>(c).then([] {
-                                return seastar::stop_iteration::no;
-                            });
-                        } else {
-                            return seastar::make_ready_future<seastar::stop_iteration>(seastar::stop_iteration::yes);
-                        }
-                    });
-                });
-            });
-        } else {
-            return skip_field();
+    auto [def, rep] = current_levels();
+    if (def > static_cast<int>(_def_level)) {
+        read_pair<Consumer>(c);
+        while (true) {
+            auto [def, rep] = current_levels();
+            if (rep <= static_cast<int>(_rep_level)) {
+                break;
+            }
+            c.separate_map_values();
+            read_pair<Consumer>(c);
         }
-    }).then([&c] {
-        c.end_map();
-    });
+    } else {
+        skip_field();
+    }
+    c.end_map();
 }
 
 template <typename Consumer>
-inline seastar::future<> map_reader::read_pair(Consumer& c) {
-    return _key_reader->read_field(c).then([this, &c] {
-        c.separate_key_value();
-        return _value_reader->read_field(c);
-    });
+inline void map_reader::read_pair(Consumer& c) {
+    _key_reader->read_field(c);
+    c.separate_key_value();
+    _value_reader->read_field(c);
 }
 
-inline seastar::future<> struct_reader::skip_field() {
-    return seastar::do_for_each(_readers.begin(), _readers.end(), [] (auto& child) {
-        return child.skip_field();
-    });
+inline void struct_reader::skip_field() {
+    for (field_reader& child : _readers) {
+        child.skip_field();
+    }
 }
 
-inline seastar::future<std::pair<int, int>> struct_reader::current_levels() {
+inline std::pair<int, int> struct_reader::current_levels() {
     if (_readers.empty()) {
-        return seastar::make_ready_future<std::pair<int, int>>(-1, -1);
+        return {-1, -1};
     }
     return _readers[0].current_levels();
 }
-inline seastar::future<> list_reader::skip_field() {
-    return _reader->skip_field();
+
+inline bool struct_reader::record_buffered() {
+    return std::all_of(_readers.begin(), _readers.end(), [] (field_reader& child) {
+        return child.record_buffered();
+    });
 }
 
-inline seastar::future<std::pair<int, int>> list_reader::current_levels() {
+inline seastar::future<> struct_reader::fill_record() {
+    return seastar::do_for_each(_readers, [] (field_reader& child) {
+        return child.fill_record();
+    });
+}
+
+inline void list_reader::skip_field() {
+    _reader->skip_field();
+}
+
+inline std::pair<int, int> list_reader::current_levels() {
     return _reader->current_levels();
 }
 
-inline seastar::future<> optional_reader::skip_field() {
-    return _reader->skip_field();
+inline bool list_reader::record_buffered() {
+    return _reader->record_buffered();
 }
 
-inline seastar::future<std::pair<int, int>> optional_reader::current_levels() {
+inline seastar::future<> list_reader::fill_record() {
+    return _reader->fill_record();
+}
+
+inline void optional_reader::skip_field() {
+    _reader->skip_field();
+}
+
+inline std::pair<int, int> optional_reader::current_levels() {
     return _reader->current_levels();
 }
 
+inline bool optional_reader::record_buffered() {
+    return _reader->record_buffered();
+}
 
-inline seastar::future<> map_reader::skip_field() {
-    co_await _key_reader->skip_field();
-    co_await _value_reader->skip_field();
-    co_return ;
+inline seastar::future<> optional_reader::fill_record() {
+    return _reader->fill_record();
 }
 
-inline seastar::future<std::pair<int, int>> map_reader::current_levels() {
+inline void map_reader::skip_field() {
+    _key_reader->skip_field();
+    _value_reader->skip_field();
+}
+
+inline std::pair<int, int> map_reader::current_levels() {
     return _key_reader->current_levels();
 }
 
+inline bool map_reader::record_buffered() {
+    return _key_reader->record_buffered() && _value_reader->record_buffered();
+}
+
+inline seastar::future<> map_reader::fill_record() {
+    co_await _key_reader->fill_record();
+    co_await _value_reader->fill_record();
+}
+
+inline bool record_reader::record_buffered() {
+    if (_field_readers.empty()) {
+        return false;
+    }
+    return std::all_of(_field_readers.begin(), _field_readers.end(), [] (field_reader& child) {
+        return child.record_buffered();
+    });
+}
+
+inline seastar::future<> record_reader::fill_record() {
+    return seastar::do_for_each(_field_readers, [] (field_reader& child) {
+        return child.fill_record();
+    });
+}
+
 inline seastar::future<std::pair<int, int>> record_reader::current_levels() {
     if (_field_readers.empty()) {
         return seastar::make_ready_future<std::pair<int, int>>(-1, -1);
     }
-    return _field_readers[0].current_levels();
+    return _field_readers[0].fill_record().then([this] {
+        return _field_readers[0].current_levels();
+    });
 }
 
-
 template <typename L>
-inline seastar::future<> typed_primitive_reader<L>::skip_field() {
-    return next().then([] (std::optional<triplet> triplet) {
-        if (!triplet) {
-            throw parquet_exception("No more values buffered");
-        }
-    });
+inline void typed_primitive_reader<L>::skip_field() {
+    if (_levels_offset == _levels_buffered) {
+        throw parquet_exception("No more values buffered");
+    }
+    if (current_def_level() == static_cast<int>(_def_level)) {
+        _values_offset++;
+    }
+    _levels_offset++;
 }
 
 template <typename L>
-inline seastar::future<std::pair<int, int>> typed_primitive_reader<L>::current_levels() {
-    return refill_when_empty().then([this] {
-        if (!_levels_buffered) {
-            return seastar::make_ready_future<std::pair<int, int>>(-1, -1);
-        } else {
-            return seastar::make_ready_future<std::pair<int, int>>(current_def_level(), current_rep_level());
-        }
-    });
+inline std::pair<int, int> typed_primitive_reader<L>::current_levels() {
+    if (_levels_offset == _levels_buffered) {
+        return {-1, -1};
+    }
+    return {current_def_level(), current_rep_level()};
 }
 
 template <typename L>
@@ -410,88 +513,115 @@ inline int typed_primitive_reader<L>::current_rep_level() {
 }
 
 template <typename L>
-inline seastar::future<> typed_primitive_reader<L>::refill_when_empty() {
+inline bool typed_primitive_reader<L>::record_buffered() {
     if (_levels_offset == _levels_buffered) {
-        return _source.read_batch(
-                _def_levels.size(),
-                _def_levels.data(),
-                _rep_levels.data(),
-                _values.data()
-        ).then([this] (size_t levels_read) {
-            _levels_buffered = levels_read;
-            _values_buffered = 0;
-            for (size_t i = 0; i < levels_read; ++i) {
-                if (_def_levels[i] == static_cast<int>(_def_level)) {
-                    ++_values_buffered;
-                }
-            }
-            _values_offset = 0;
-            _levels_offset = 0;
-        }).handle_exception_type([this] (const std::exception& e){
-            throw parquet_exception(seastar::format(
-                        "In column {}: {}", _name, e.what()));
-        });
+        return false;
     }
-    return seastar::make_ready_future<>();
+    if (_rep_level == 0 || _eof) {
+        // Every level is a record, or the rest of the column is buffered.
+        return true;
+    }
+    // The record is complete once the level which begins the next one is buffered.
+    if (_next_record <= _levels_offset) {
+        _next_record = _rep_levels.find(_levels_offset + 1, _levels_buffered, 0);
+    }
+    return _next_record < _levels_buffered;
 }
 
 template <typename L>
-inline seastar::future<std::optional<typename typed_primitive_reader<L>::triplet>> typed_primitive_reader<L>::next() {
-    return refill_when_empty().then([this] {
-        if (!_levels_buffered) {
-            return std::optional<triplet>{};
-        }
-        int16_t def_level = current_def_level();
-        int16_t rep_level = current_rep_level();
-        _levels_offset++;
-        bool is_null = def_level < static_cast<int>(_def_level);
-        if (is_null) {
-            return std::optional<triplet>{{def_level, rep_level, std::nullopt}};
-        }
-        if (_values_offset == _values_buffered) {
-            throw parquet_exception("Value was non-null, but has not been buffered");
+inline seastar::future<> typed_primitive_reader<L>::fill_record() {
+    if (_eof || record_buffered()) {
+        return seastar::make_ready_future<>();
+    }
+    // The unconsumed levels and values (the beginning of a record which continues in the next batch)
+    // are moved to the front, and the next batch is appended to them.
+    size_t levels_left = _levels_buffered - _levels_offset;
+    size_t values_left = _values_buffered - _values_offset;
+    _def_levels.move_to_front(_levels_offset, _levels_buffered);
+    _rep_levels.move_to_front(_levels_offset, _levels_buffered);
+    std::move(_values.begin() + _values_offset, _values.begin() + _values_buffered, _values.begin());
+    _levels_offset = 0;
+    _values_offset = 0;
+    _levels_buffered = levels_left;
+    _values_buffered = values_left;
+    _next_record = 0;
+    if (levels_left == _def_levels.size()) {
+        // A record longer than the buffer.
+        _def_levels.resize(2 * levels_left);
+        _rep_levels.resize(2 * levels_left);
+        _values.resize(2 * levels_left);
+    }
+    auto read = _def_levels.wide() ? read_levels<int16_t>(levels_left, values_left)
+                                   : read_levels<uint8_t>(levels_left, values_left);
+    return std::move(read).handle_exception_type([this] (const std::exception& e) {
+        return seastar::make_exception_future<size_t>(parquet_exception(seastar::format(
+                "In column {}: {}", _name, e.what())));
+    }).then([this] (size_t levels_read) {
+        if (levels_read == 0) {
+            _eof = true;
         }
-        output_type& val = _values[_values_offset++];
-        return std::optional<triplet>{{def_level, rep_level, std::move(val)}};
+        _levels_buffered += levels_read;
+        return fill_record();
     });
 }
 
+template <typename L>
+template <typename LevelT>
+inline seastar::future<size_t> typed_primitive_reader<L>::read_levels(size_t levels_offset, size_t values_offset) {
+    return _source.read_batch(
+            _def_levels.size() - levels_offset,
+            _def_levels.data<LevelT>() + levels_offset,
+            _rep_levels.data<LevelT>() + levels_offset,
+            _values.data() + values_offset,
+            &_values_buffered);
+}
+
 template <typename Consumer>
-inline seastar::future<> record_reader::read_one(Consumer& c) {
+inline void record_reader::read_buffered(Consumer& c) {
     c.start_record();
-    return seastar::do_for_each(_field_readers, [&c] (auto& child) {
-        return child.current_levels().then([&c, &child] (std::pair<int,int> level) {
-            auto def = level.first;
-            c.start_column(child.name());
-            return std::visit(overloaded {
-                [def, &c] (optional_reader& typed_child) {
-                    if (def > 0) {
-                        return typed_child.read_field(c);
-                    } else {
-                        c.append_null();
-                        return typed_child.skip_field();
-                    }
-                },
-                [&c] (auto& typed_child) {
-                    return typed_child.read_field(c);
+    for (field_reader& child : _field_readers) {
+        auto def = child.current_levels().first;
+        c.start_column(child.name());
+        std::visit(overloaded {
+            [def, &c] (optional_reader& typed_child) {
+                if (def > 0) {
+                    typed_child.read_field(c);
+                } else {
+                    c.append_null();
+                    typed_child.skip_field();
                 }
-            }, child._reader);
-        });
-    }).then([&c] {
-        c.end_record();
+            },
+            [&c] (auto& typed_child) {
+                typed_child.read_field(c);
+            }
+        }, child._reader);
+    }
+    c.end_record();
+}
+
+template <typename Consumer>
+inline seastar::future<> record_reader::read_one(Consumer& c) {
+    if (record_buffered()) {
+        return seastar::futurize_invoke([this, &c] { read_buffered(c); });
+    }
+    return fill_record().then([this, &c] {
+        read_buffered(c);
     });
 }
 
 template <typename Consumer>
 inline seastar::future<> record_reader::read_all(Consumer& c) {
     return seastar::repeat([this, &c] {
-        return current_levels().then([this, &c] (std::pair<int,int> level) {
-            auto def = level.first;
-            if (def < 0) {
-                return seastar::make_ready_future<seastar::stop_iteration>(seastar::stop_iteration::yes);
-            } else {
-                return read_one<Consumer>(c).then([] { return seastar::stop_iteration::no; });
+        // Buffered records are assembled by plain calls. A future is only needed when a column
+        // has to read its next batch.
+        while (record_buffered()) {
+            read_buffered(c);
+            if (seastar::need_preempt()) {
+                return seastar::make_ready_future<seastar::stop_iteration>(seastar::stop_iteration::no);
             }
+        }
+        return fill_record().then([this] {
+            return seastar::stop_iteration(!record_buffered());
         });
     });
 }
@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <vector>
 
 #include <parquet4seastar/bit_stream_utils.hh>
@@ -88,6 +89,52 @@ constexpr int64_t CeilDiv(int64_t value, int64_t divisor) {
 
 } // namespace BitUtil
 
+/// Appends bits to a bitmap, least significant bit first, from an arbitrary bit offset.
+/// The bits before the offset are preserved. Bits are gathered in a word and stored a
+/// byte at a time; Finish() stores the last, partial byte (with its upper bits cleared).
+class BitmapWriter {
+ public:
+  BitmapWriter(uint8_t* bitmap, int64_t bit_offset)
+      : out_(bitmap + bit_offset / 8), acc_bits_(static_cast<int>(bit_offset % 8)) {
+    acc_ = acc_bits_ == 0 ? 0 : *out_ & ((1u << acc_bits_) - 1);
+  }
+
+  /// Appends the lowest n bits of 'bits'. n must be <= 32.
+  void Put(uint32_t bits, int n) {
+    acc_ |= (static_cast<uint64_t>(bits) & ((uint64_t{1} << n) - 1)) << acc_bits_;
+    acc_bits_ += n;
+    while (acc_bits_ >= 8) {
+      *out_++ = static_cast<uint8_t>(acc_);
+      acc_ >>= 8;
+      acc_bits_ -= 8;
+    }
+  }
+
+  /// Appends n copies of 'bit'. Whole bytes are filled with memset.
+  void PutRun(bool bit, int64_t n) {
+    const uint32_t bits = bit ? 0xffffffffu : 0;
+    while (n > 0 && acc_bits_ != 0) {
+      int k = static_cast<int>(std::min<int64_t>(n, 8 - acc_bits_));
+      Put(bits, k);
+      n -= k;
+    }
+    std::memset(out_, bit ? 0xff : 0, n / 8);
+    out_ += n / 8;
+    Put(bits, static_cast<int>(n % 8));
+  }
+
+  void Finish() {
+    if (acc_bits_ > 0) {
+      *out_ = static_cast<uint8_t>(acc_);
+    }
+  }
+
+ private:
+  uint8_t* out_;
+  int acc_bits_;
+  uint64_t acc_;
+};
+
 /// Decoder class for RLE encoded data.
 class RleDecoder {
  public:
@@ -123,6 +170,35 @@ class RleDecoder {
   template <typename T>
   int GetBatch(T* values, int batch_size);
 
+  /// Gets a batch of values, like GetBatch. Also adds the number of values equal to
+  /// 'value' to *matches, and raises *max_value to the greatest decoded value.
+  /// Repeated runs are counted and checked once per run. Literal runs are counted
+  /// in a single pass over the unpacked values.
+  template <typename T>
+  int GetBatchWithStats(T* values, int batch_size, T value, uint32_t* matches, uint64_t* max_value);
+
+  /// Gets a batch of dictionary indices, and writes the dictionary entries they point
+  /// to into 'values'. Literal runs are unpacked a block at a time, checked against
+  /// 'dictionary_length' with a single max over the block, and gathered. Repeated runs
+  /// are checked once and filled. Raises *max_index to the greatest index decoded, and
+  /// stops before the first block or run with an index out of range, so the caller
+  /// can tell a corrupted page by *max_index >= dictionary_length.
+  template <typename T>
+  int GetBatchWithDict(const T* dictionary, int32_t dictionary_length, T* values, int batch_size,
+                       uint64_t* max_index);
+
+  /// Gets a batch of values of bit width 1 as a bitmap. Literal runs are already
+  /// bitmaps, so they are copied 32 values at a time, and repeated runs are filled.
+  /// Adds the number of set bits to *set_count. Literals always fit in 1 bit, but a
+  /// repeated value may be corrupted and wider, so *max_value is raised to the greatest
+  /// repeated value.
+  int GetBitmap(BitmapWriter* writer, int batch_size, uint32_t* set_count, uint64_t* max_value);
+
+  /// Skips a batch of values. Repeated runs are skipped without decoding.
+  /// If 'matches' is not null, the number of skipped values equal to 'value' is
+  /// added to it. Returns the number of skipped values.
+  int Skip(int batch_size, uint64_t value = 0, int* matches = nullptr);
+
  protected:
   BitUtil::BitReader bit_reader_;
   /// Number of bits needed to encode the value. Must be between 0 and 64.
@@ -132,6 +208,16 @@ class RleDecoder {
   int32_t literal_count_;
 
  private:
+  /// The output never aliases the dictionary. Telling the compiler so lets it use
+  /// gather instructions where they are available.
+  template <typename T>
+  static void GatherFromDict(const T* __restrict dictionary, const uint32_t* __restrict indices, int n,
+                             T* __restrict out) {
+    for (int i = 0; i < n; ++i) {
+      out[i] = dictionary[indices[i]];
+    }
+  }
+
   /// Fills literal_count_ and repeat_count_ with next values. Returns false if there
   /// are no more.
   template <typename T>
@@ -314,6 +400,191 @@ inline int RleDecoder::GetBatch(T* values, int batch_size) {
   return values_read;
 }
 
+template <typename T>
+inline int RleDecoder::GetBatchWithStats(T* values, int batch_size, T value, uint32_t* matches,
+                                         uint64_t* max_value) {
+  assert(bit_width_ >= 0);
+  int values_read = 0;
+
+  auto* out = values;
+
+  while (values_read < batch_size) {
+    int remaining = batch_size - values_read;
+
+    if (repeat_count_ > 0) {
+      int repeat_batch = std::min(remaining, repeat_count_);
+      std::fill(out, out + repeat_batch, static_cast<T>(current_value_));
+      // The run value is checked before the cast, so that values wider than T are caught.
+      *matches += (current_value_ == static_cast<uint64_t>(value)) * repeat_batch;
+      *max_value = std::max(*max_value, current_value_);
+
+      repeat_count_ -= repeat_batch;
+      values_read += repeat_batch;
+      out += repeat_batch;
+    } else if (literal_count_ > 0) {
+      int literal_batch = std::min(remaining, literal_count_);
+      int actual_read = bit_reader_.GetBatch(bit_width_, out, literal_batch);
+      if (actual_read != literal_batch) {
+        return values_read;
+      }
+      // Unpacked literals fit in bit_width_ bits, so they are never negative.
+      uint32_t literal_matches = 0;
+      T literal_max = 0;
+      for (int i = 0; i < literal_batch; ++i) {
+        literal_matches += out[i] == value;
+        literal_max = std::max(literal_max, out[i]);
+      }
+      *matches += literal_matches;
+      *max_value = std::max(*max_value, static_cast<uint64_t>(literal_max));
+
+      literal_count_ -= literal_batch;
+      values_read += literal_batch;
+      out += literal_batch;
+    } else {
+      if (!NextCounts<T>()) return values_read;
+    }
+  }
+
+  return values_read;
+}
+
+template <typename T>
+inline int RleDecoder::GetBatchWithDict(const T* dictionary, int32_t dictionary_length, T* values,
+                                        int batch_size, uint64_t* max_index) {
+  assert(bit_width_ >= 0);
+  constexpr int kBufferSize = 1024;
+  uint32_t indices[kBufferSize];
+  int values_read = 0;
+
+  auto* out = values;
+
+  while (values_read < batch_size) {
+    int remaining = batch_size - values_read;
+
+    if (repeat_count_ > 0) {
+      *max_index = std::max(*max_index, current_value_);
+      if (current_value_ >= static_cast<uint64_t>(dictionary_length)) {
+        return values_read;
+      }
+      int repeat_batch = std::min(remaining, repeat_count_);
+      std::fill(out, out + repeat_batch, dictionary[current_value_]);
+
+      repeat_count_ -= repeat_batch;
+      values_read += repeat_batch;
+      out += repeat_batch;
+    } else if (literal_count_ > 0) {
+      int literal_batch = std::min({remaining, literal_count_, kBufferSize});
+      int actual_read = bit_reader_.GetBatch(bit_width_, indices, literal_batch);
+      if (actual_read != literal_batch) {
+        return values_read;
+      }
+      // A branch-free max, rather than a check per index, lets the compiler vectorize both loops.
+      uint32_t literal_max = 0;
+      for (int i = 0; i < literal_batch; ++i) {
+        literal_max = std::max(literal_max, indices[i]);
+      }
+      *max_index = std::max(*max_index, static_cast<uint64_t>(literal_max));
+      if (literal_max >= static_cast<uint32_t>(dictionary_length)) {
+        return values_read;
+      }
+      GatherFromDict(dictionary, indices, literal_batch, out);
+
+      literal_count_ -= literal_batch;
+      values_read += literal_batch;
+      out += literal_batch;
+    } else {
+      if (!NextCounts<uint32_t>()) return values_read;
+    }
+  }
+
+  return values_read;
+}
+
+inline int RleDecoder::GetBitmap(BitmapWriter* writer, int batch_size, uint32_t* set_count,
+                                  uint64_t* max_value) {
+  assert(bit_width_ == 1);
+  int values_read = 0;
+
+  while (values_read < batch_size) {
+    int remaining = batch_size - values_read;
+
+    if (repeat_count_ > 0) {
+      int repeat_batch = std::min(remaining, repeat_count_);
+      const bool bit = current_value_ & 1;
+      writer->PutRun(bit, repeat_batch);
+      *set_count += bit * repeat_batch;
+      *max_value = std::max(*max_value, current_value_);
+
+      repeat_count_ -= repeat_batch;
+      values_read += repeat_batch;
+    } else if (literal_count_ > 0) {
+      int literal_batch = std::min(remaining, literal_count_);
+      for (int i = 0; i < literal_batch; i += 32) {
+        int n = std::min(32, literal_batch - i);
+        uint32_t word = 0;
+        if (!bit_reader_.GetValue(n, &word)) {
+          literal_count_ -= i;
+          return values_read + i;
+        }
+        writer->Put(word, n);
+        *set_count += __builtin_popcount(word);
+      }
+
+      literal_count_ -= literal_batch;
+      values_read += literal_batch;
+    } else {
+      if (!NextCounts<uint64_t>()) return values_read;
+    }
+  }
+
+  return values_read;
+}
+
+inline int RleDecoder::Skip(int batch_size, uint64_t value, int* matches) {
+  assert(bit_width_ >= 0);
+  int values_skipped = 0;
+
+  while (values_skipped < batch_size) {
+    int remaining = batch_size - values_skipped;
+
+    if (repeat_count_ > 0) {
+      int repeat_batch = std::min(remaining, repeat_count_);
+      if (matches && current_value_ == value) {
+        *matches += repeat_batch;
+      }
+
+      repeat_count_ -= repeat_batch;
+      values_skipped += repeat_batch;
+    } else if (literal_count_ > 0) {
+      int literal_batch = std::min(remaining, literal_count_);
+      if (matches) {
+        // Counting requires decoding the literals.
+        assert(bit_width_ <= 32);
+        constexpr int kUnpackBatchSize = 256;
+        uint32_t unpacked[kUnpackBatchSize];
+        literal_batch = std::min(literal_batch, kUnpackBatchSize);
+        int actual_read = bit_reader_.GetBatch(bit_width_, unpacked, literal_batch);
+        if (actual_read != literal_batch) {
+          return values_skipped;
+        }
+        *matches += std::count(unpacked, unpacked + literal_batch, value);
+      } else {
+        int actual_skipped = bit_reader_.Skip(bit_width_, literal_batch);
+        if (actual_skipped != literal_batch) {
+          return values_skipped;
+        }
+      }
+
+      literal_count_ -= literal_batch;
+      values_skipped += literal_batch;
+    } else {
+      if (!NextCounts<uint64_t>()) return values_skipped;
+    }
+  }
+
+  return values_skipped;
+}
+
 static inline bool IndexInRange(int32_t idx, int32_t dictionary_length) {
   return idx >= 0 && idx < dictionary_length;
 }
@@ -0,0 +1,63 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace parquet4seastar {
+
+// Rows [begin, end) of a column chunk.
+struct row_range
+{
+    uint64_t begin;
+    uint64_t end;
+    bool operator==(const row_range&) const = default;
+};
+
+/* A set of rows selected for reading, e.g. the rows which passed a filter.
+ * Stored as sorted, disjoint ranges, so that the rows in between can be skipped in bulk.
+ * Adjacent ranges are merged.
+ */
+class row_selection
+{
+    std::vector<row_range> _ranges;
+    uint64_t _row_count = 0;
+
+   public:
+    row_selection() = default;
+    // Select the rows whose bits are set. Bits are numbered from the least significant bit of the first byte.
+    static row_selection from_bitmap(const uint8_t* bits, uint64_t n_rows);
+    // Select all of rows [0, n_rows).
+    static row_selection all(uint64_t n_rows);
+
+    // Append rows [begin, end). The range must not precede the ranges added before.
+    void add(uint64_t begin, uint64_t end);
+
+    const std::vector<row_range>& ranges() const { return _ranges; }
+    // The number of selected rows.
+    uint64_t row_count() const { return _row_count; }
+    bool empty() const { return _row_count == 0; }
+};
+
+}  // namespace parquet4seastar
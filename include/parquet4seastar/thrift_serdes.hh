@@ -27,17 +27,25 @@
 
 #include <parquet4seastar/bytes.hh>
 #include <parquet4seastar/exception.hh>
+#include <parquet4seastar/reader_memory.hh>
 #include <seastar/core/fstream.hh>
 #include <seastar/core/print.hh>
+#include <vector>
 
 namespace parquet4seastar {
 
+namespace format {
+class PageHeader;
+}
+
 /* A dynamically sized buffer. Rounds up the size given in constructor to a power of 2.
  */
 class buffer
 {
     size_t _size;
     std::unique_ptr<byte[]> _data;
+
+   public:
     static constexpr inline uint64_t next_power_of_2(uint64_t n) {
         if (n < 2) {
             return n;
@@ -45,10 +53,10 @@ class buffer
         return 1ull << seastar::log2ceil(n);
     }
 
-   public:
-    explicit buffer(size_t size = 0) : _size(next_power_of_2(size)), _data(new byte[_size]) {}
+    explicit buffer(size_t size = 0) : _size(next_power_of_2(size)), _data(_size ? new byte[_size] : nullptr) {}
     byte* data() { return _data.get(); }
-    size_t size() { return _size; }
+    const byte* data() const { return _data.get(); }
+    size_t size() const { return _size; }
 };
 
 class IPeekableStream
@@ -60,6 +68,8 @@ class IPeekableStream
     virtual seastar::future<bytes_view> peek(size_t n) = 0;
     // Consume n bytes. If there is less than n bytes in stream, throw.
     virtual seastar::future<> advance(size_t n) = 0;
+    // Streams which buffer data should charge their buffers against the limiter.
+    virtual void set_memory_limiter(reader_memory_limiter*) {}
 };
 
 /* The problem: we need to read a stream of objects of unknown, variable size (page headers)
@@ -73,11 +83,11 @@ class peekable_stream
 {
     seastar::input_stream<char> _source;
     buffer _buffer;
+    reader_memory_charge _buffer_charge;
     size_t _buffer_start = 0;
     size_t _buffer_end = 0;
 
-
-    void ensure_space(size_t n);
+    seastar::future<> ensure_space(size_t n);
     seastar::future<> read_exactly(size_t n);
 
    public:
@@ -87,6 +97,9 @@ class peekable_stream
     seastar::future<bytes_view> peek(size_t n);
     // Consume n bytes. If there is less than n bytes in stream, throw.
     seastar::future<> advance(size_t n);
+    void set_memory_limiter(reader_memory_limiter* limiter) override {
+        _buffer_charge = reader_memory_charge{limiter};
+    }
 };
 
 // Deserialize a single thrift structure. Return the number of bytes used.
@@ -161,4 +174,60 @@ seastar::future<bool> read_thrift_from_stream(IPeekableStream& stream, Deseriali
       });
 }
 
+/* Page headers are read once per page, which makes their parsing a noticeable part of reading small pages.
+ * So they have a decoder of their own, specialized for PageHeader and the compact protocol. It parses straight
+ * from a view of the stream, without the transport and protocol objects and the virtual calls of Thrift,
+ * and reuses the memory of the header, including its statistics strings. Unknown fields are skipped, as in Thrift.
+ */
+struct page_header_parse_result
+{
+    // The size of the header, or 0 if the view ends before the header does.
+    size_t size;
+    // If the view ends before the header does, a lower bound on the size of the header.
+    size_t min_size;
+};
+// Deserialize a PageHeader from the beginning of data. Throw if the header is invalid.
+page_header_parse_result deserialize_page_header(bytes_view data, format::PageHeader& header);
+
+/* Finds the size of a compact protocol struct from growing prefixes of it, without deserializing it.
+ * Between calls it keeps its position and the stack of structs, lists and maps it is in, so every byte
+ * is scanned once, however many times the prefix has to grow.
+ */
+class compact_struct_scanner
+{
+    struct frame
+    {
+        // The thrift type of the frame (struct, list, set or map) and of its elements.
+        uint8_t kind;
+        uint8_t key;
+        uint8_t value;
+        // Whether the next element of a map is a value.
+        bool value_next = false;
+        // The elements of a list or map left to scan.
+        uint64_t remaining = 0;
+    };
+    std::vector<frame> _stack;
+    // The type of the value to be scanned next, or STOP if there is none.
+    uint8_t _pending;
+    size_t _pos = 0;
+    size_t _min_size = 0;
+
+    size_t need(size_t n);
+
+   public:
+    compact_struct_scanner();
+    // data is a prefix of the struct, at least as long as in the previous call. Return the size of the struct,
+    // or 0 if data ends before the struct does. min_size() is then a lower bound on the size of the struct.
+    size_t scan(bytes_view data);
+    size_t min_size() const { return _min_size; }
+};
+
+// Deserialize (and consume from the stream) a single page header. Return false if the stream is empty.
+// If the header turns out bigger than expected_size, its exact size is found with compact_struct_scanner
+// from views twice as big, or of the scanner's min_size if that is bigger. It is then parsed once more.
+// Throw if the header is bigger than max_allowed_size.
+seastar::future<bool> read_page_header_from_stream(IPeekableStream& stream, format::PageHeader& header,
+                                                   size_t expected_size = 1024,
+                                                   size_t max_allowed_size = 1024 * 1024 * 16);
+
 }  // namespace parquet4seastar
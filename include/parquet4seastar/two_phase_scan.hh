@@ -0,0 +1,130 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+
+#pragma once
+
+#include <parquet4seastar/file_reader.hh>
+#include <parquet4seastar/row_selection.hh>
+
+namespace parquet4seastar {
+
+// The selected rows of a column, compacted.
+template <format::Type::type T>
+struct projected_column
+{
+    using output_type = typename column_chunk_reader<T>::output_type;
+    std::vector<int16_t> def_levels;
+    std::vector<int16_t> rep_levels;
+    std::vector<output_type> values;
+    size_t rows = 0;
+};
+
+/* Late materialization of filter-then-project queries in a single row group.
+ * First, filter() evaluates predicates on (cheap) filter columns, each one only on the rows which passed
+ * the previous filters. Then, project() reads only the selected rows of the (wide) projected columns.
+ * The rows in between are skipped without decoding them, and pages without selected rows aren't decompressed.
+ *
+ * The file_reader has to outlive the scan, and the scan has to outlive the returned futures.
+ */
+class two_phase_scan
+{
+    file_reader& _file;
+    uint32_t _row_group;
+    row_selection _selection;
+
+    const reader_schema::raw_node& leaf(uint32_t column) {
+        if (column >= _file.raw_schema().leaves.size()) {
+            throw parquet_exception(seastar::format("Column {} out of range (the file has {} columns)", column,
+                                                    _file.raw_schema().leaves.size()));
+        }
+        return *_file.raw_schema().leaves[column];
+    }
+
+   public:
+    two_phase_scan(file_reader& file, uint32_t row_group) : _file{file}, _row_group{row_group} {
+        if (row_group >= _file.metadata().row_groups.size()) {
+            throw parquet_exception(seastar::format("Row group {} out of range (the file has {} row groups)", row_group,
+                                                    _file.metadata().row_groups.size()));
+        }
+        _selection = row_selection::all(_file.metadata().row_groups[row_group].num_rows);
+    }
+
+    // Keep only the selected rows for which pred returns true. pred is called with a pointer to the value
+    // of each selected row in column, or with nullptr if the value is null. Only flat columns can be filtered on.
+    template <format::Type::type T, typename Predicate>
+    seastar::future<> filter(uint32_t column, Predicate pred);
+
+    // Read the selected rows of column.
+    template <format::Type::type T>
+    seastar::future<projected_column<T>> project(uint32_t column);
+
+    const row_selection& selection() const { return _selection; }
+};
+
+template <format::Type::type T, typename Predicate>
+seastar::future<> two_phase_scan::filter(uint32_t column, Predicate pred) {
+    using output_type = typename column_chunk_reader<T>::output_type;
+    const reader_schema::raw_node& node = leaf(column);
+    if (node.rep_level > 0) {
+        throw parquet_exception(seastar::format("Can't filter on column {}: only flat columns are supported", column));
+    }
+    column_chunk_reader<T> reader = co_await _file.open_column_chunk_reader<T>(_row_group, column);
+    std::vector<int16_t> def;
+    std::vector<int16_t> rep;
+    std::vector<output_type> val;
+    co_await reader.read_selected(_selection, def, rep, val);
+    // Flat columns have exactly one level per row, and one value per non-null level.
+    if (def.size() != _selection.row_count()) {
+        throw parquet_exception::corrupted_file(seastar::format(
+          "Column {} of row group {} has {} selected rows, expected {}", column, _row_group, def.size(),
+          _selection.row_count()));
+    }
+
+    row_selection passed;
+    size_t level = 0;
+    size_t value = 0;
+    for (const row_range& range : _selection.ranges()) {
+        for (uint64_t row = range.begin; row < range.end; ++row, ++level) {
+            bool is_null = def[level] < static_cast<int16_t>(node.def_level);
+            if (!is_null && value == val.size()) {
+                throw parquet_exception::corrupted_file(
+                  seastar::format("Column {} of row group {} has fewer values than non-null rows", column, _row_group));
+            }
+            const output_type* v = is_null ? nullptr : &val[value++];
+            if (pred(v)) {
+                passed.add(row, row + 1);
+            }
+        }
+    }
+    _selection = std::move(passed);
+}
+
+template <format::Type::type T>
+seastar::future<projected_column<T>> two_phase_scan::project(uint32_t column) {
+    leaf(column);
+    column_chunk_reader<T> reader = co_await _file.open_column_chunk_reader<T>(_row_group, column);
+    projected_column<T> out;
+    out.rows = co_await reader.read_selected(_selection, out.def_levels, out.rep_levels, out.values);
+    co_return out;
+}
+
+}  // namespace parquet4seastar
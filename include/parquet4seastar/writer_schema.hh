@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <parquet4seastar/compression.hh>
 #include <parquet4seastar/logical_type.hh>
 
 namespace parquet4seastar::writer_schema {
@@ -39,6 +40,7 @@ struct primitive_node {
     std::optional<uint32_t> type_length;
     format::Encoding::type encoding;
     format::CompressionCodec::type compression;
+    compressor_options compression_options = {};
 };
 
 struct list_node {
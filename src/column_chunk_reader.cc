@@ -25,44 +25,57 @@
 namespace parquet4seastar {
 
 seastar::future<std::optional<page>> page_reader::next_page() {
-    *_latest_header = format::PageHeader{};  // Thrift does not clear the structure by itself before writing to it.
+    // The header is parsed in place. The parser resets all of its fields, but keeps the memory of its strings.
     assert(_source != nullptr);
-    return read_thrift_from_stream(*_source, *_latest_header).then([this](bool read) {
-        if (!read) {
-            return seastar::make_ready_future<std::optional<page>>();
-        }
-        if (_latest_header->compressed_page_size < 0) {
-            throw parquet_exception::corrupted_file(seastar::format("Negative compressed_page_size in header"));
-            // throw parquet_exception::corrupted_file(seastar::format(
-            //         "Negative compressed_page_size in header: {}", *_latest_header));
-        }
-        size_t compressed_size = static_cast<uint32_t>(_latest_header->compressed_page_size);
-        return _source->peek(compressed_size).then([this, compressed_size](bytes_view page_contents) {
-            if (page_contents.size() < compressed_size) {
-                throw parquet_exception::corrupted_file(seastar::format(
-                  "Unexpected end of column chunk while reading compressed page contents (expected {}B, got {}B)",
-                  compressed_size, page_contents.size()));
-            }
-            return _source->advance(compressed_size).then([this, page_contents] {
-                return seastar::make_ready_future<std::optional<page>>(page{_latest_header.get(), page_contents});
-            });
-        });
-    });
+    return read_page_header_from_stream(*_source, *_latest_header, _default_expected_header_size,
+                                        _max_allowed_header_size)
+      .then([this](bool read) {
+          if (!read) {
+              return seastar::make_ready_future<std::optional<page>>();
+          }
+          if (_latest_header->compressed_page_size < 0) {
+              throw parquet_exception::corrupted_file(seastar::format("Negative compressed_page_size in header"));
+              // throw parquet_exception::corrupted_file(seastar::format(
+              //         "Negative compressed_page_size in header: {}", *_latest_header));
+          }
+          size_t compressed_size = static_cast<uint32_t>(_latest_header->compressed_page_size);
+          return _source->peek(compressed_size).then([this, compressed_size](bytes_view page_contents) {
+              if (page_contents.size() < compressed_size) {
+                  throw parquet_exception::corrupted_file(seastar::format(
+                    "Unexpected end of column chunk while reading compressed page contents (expected {}B, got {}B)",
+                    compressed_size, page_contents.size()));
+              }
+              return _source->advance(compressed_size).then([this, page_contents] {
+                  return seastar::make_ready_future<std::optional<page>>(page{_latest_header.get(), page_contents});
+              });
+          });
+      });
 }
 
 template <format::Type::type T>
-bytes_view column_chunk_reader<T>::decompress(bytes_view compressed, size_t uncompressed_size) {
+seastar::future<bytes_view> column_chunk_reader<T>::decompress(bytes_view compressed, size_t uncompressed_size) {
     if (_decompressor->type() == format::CompressionCodec::UNCOMPRESSED) {
-        return compressed;
-    } else {
-        _decompression_buffer.resize(uncompressed_size);
-        _decompression_buffer = _decompressor->decompress(compressed, std::move(_decompression_buffer));
-        return _decompression_buffer;
+        return seastar::make_ready_future<bytes_view>(compressed);
+    }
+    if (_decompression_buffer.size() < uncompressed_size) {
+        return _decompression_charge.resize(buffer::next_power_of_2(uncompressed_size))
+          .then([this, compressed, uncompressed_size] {
+              _decompression_buffer = buffer{uncompressed_size};
+              return decompress(compressed, uncompressed_size);
+          });
+    }
+    std::span<byte> out{_decompression_buffer.data(), uncompressed_size};
+    if (_offload) {
+        return _offload->decompress(*_decompressor, compressed, out).then([this](size_t n) {
+            return bytes_view{_decompression_buffer.data(), n};
+        });
     }
+    size_t n = _decompressor->decompress(compressed, out);
+    return seastar::make_ready_future<bytes_view>(_decompression_buffer.data(), n);
 }
 
 template <format::Type::type T>
-void column_chunk_reader<T>::load_data_page(page p) {
+seastar::future<> column_chunk_reader<T>::load_data_page(page p) {
     if (!p.header->__isset.data_page_header) {
         // throw parquet_exception::corrupted_file(seastar::format(
         //         "DataPageHeader not set for DATA_PAGE header: {}", *p.header));
@@ -80,18 +93,18 @@ void column_chunk_reader<T>::load_data_page(page p) {
         throw parquet_exception::corrupted_file(seastar::format("Negative uncompressed_page_size in header"));
     }
 
-    bytes_view contents = decompress(p.contents, p.header->uncompressed_page_size);
-
-    size_t n_read = 0;
-    n_read = _rep_decoder.reset_v1(contents, header.repetition_level_encoding, header.num_values);
-    contents.remove_prefix(n_read);
-    n_read = _def_decoder.reset_v1(contents, header.definition_level_encoding, header.num_values);
-    contents.remove_prefix(n_read);
-    _val_decoder.reset(contents, header.encoding);
+    return decompress(p.contents, p.header->uncompressed_page_size).then([this, &header](bytes_view contents) {
+        size_t n_read = 0;
+        n_read = _rep_decoder.reset_v1(contents, header.repetition_level_encoding, header.num_values);
+        contents.remove_prefix(n_read);
+        n_read = _def_decoder.reset_v1(contents, header.definition_level_encoding, header.num_values);
+        contents.remove_prefix(n_read);
+        _val_decoder.reset(contents, header.encoding);
+    });
 }
 
 template <format::Type::type T>
-void column_chunk_reader<T>::load_data_page_v2(page p) {
+seastar::future<> column_chunk_reader<T>::load_data_page_v2(page p) {
     if (!p.header->__isset.data_page_header_v2) {
         // throw parquet_exception::corrupted_file(seastar::format(
         //         "DataPageHeaderV2 not set for DATA_PAGE_V2 header: {}", *p.header));
@@ -122,13 +135,16 @@ void column_chunk_reader<T>::load_data_page_v2(page p) {
     if (header.__isset.is_compressed && header.is_compressed) {
         size_t n_read = header.repetition_levels_byte_length + header.definition_levels_byte_length;
         size_t uncompressed_values_size = static_cast<size_t>(p.header->uncompressed_page_size) - n_read;
-        contents = decompress(contents, uncompressed_values_size);
+        return decompress(contents, uncompressed_values_size).then([this, &header](bytes_view contents) {
+            _val_decoder.reset(contents, header.encoding);
+        });
     }
     _val_decoder.reset(contents, header.encoding);
+    return seastar::make_ready_future<>();
 }
 
 template <format::Type::type T>
-void column_chunk_reader<T>::load_dictionary_page(page p) {
+seastar::future<> column_chunk_reader<T>::load_dictionary_page(page p) {
     if (!p.header->__isset.dictionary_page_header) {
         // throw parquet_exception::corrupted_file(seastar::format(
         //         "DictionaryPageHeader not set for DICTIONARY_PAGE header: {}", *p.header));
@@ -144,16 +160,89 @@ void column_chunk_reader<T>::load_dictionary_page(page p) {
         //         seastar::format("Negative uncompressed_page_size in header: {}", *p.header));
         throw parquet_exception::corrupted_file(seastar::format("Negative uncompressed_page_size in header"));
     }
-    _dict = std::vector<output_type>(header.num_values);
-    bytes_view contents = decompress(p.contents, p.header->uncompressed_page_size);
-    value_decoder<T> vd{_type_length};
-    vd.reset(contents, format::Encoding::PLAIN);
-    size_t n_read = vd.read_batch(_dict->size(), _dict->data());
-    if (n_read < _dict->size()) {
+    // Byte array dictionary entries are views of a copy of the page.
+    size_t dict_memory = header.num_values * sizeof(output_type);
+    if constexpr (T == format::Type::BYTE_ARRAY || T == format::Type::FIXED_LEN_BYTE_ARRAY) {
+        dict_memory += p.header->uncompressed_page_size;
+    }
+    // A new dictionary rather than an overwrite, since handles to the previous one may still be alive.
+    // It holds its own charge, so that the charge is released with the last handle rather than with the reader.
+    auto dict = std::make_shared<charged_dictionary>();
+    dict->charge = reader_memory_charge{_memory_limiter};
+    return dict->charge.resize(dict_memory)
+      .then([this, p] { return decompress(p.contents, p.header->uncompressed_page_size); })
+      .then([this, &header, dict](bytes_view contents) {
+          std::vector<output_type>& values = dict->values;
+          values.resize(header.num_values);
+          value_decoder<T> vd{_type_length};
+          vd.reset(contents, format::Encoding::PLAIN);
+          size_t n_read = vd.read_batch(values.size(), values.data());
+          if (n_read < values.size()) {
+              throw parquet_exception::corrupted_file(seastar::format(
+                "Unexpected end of dictionary page (expected {} values, got {})", values.size(), n_read));
+          }
+          _dict = std::shared_ptr<std::vector<output_type>>(dict, &values);
+          _val_decoder.reset_dict(_dict->data(), _dict->size());
+          if (_dictionary_listener) {
+              _dictionary_listener(_dict);
+          }
+      });
+}
+
+template <format::Type::type T>
+void column_chunk_reader<T>::select_page_kernel() {
+    value_source val = _val_decoder.plain_encoded()        ? value_source::plain
+                       : _val_decoder.dictionary_encoded() ? value_source::dictionary
+                                                           : value_source::other;
+    size_t def = static_cast<size_t>(_def_decoder.current_source());
+    size_t rep = static_cast<size_t>(_rep_decoder.current_source());
+    _page_kernel = (def * level_decoder::source_count + rep) * value_source_count + static_cast<size_t>(val);
+}
+
+template <format::Type::type T>
+void column_chunk_reader<T>::check_chunk(size_t def_levels_read, size_t rep_levels_read, uint64_t max_def,
+                                         uint64_t max_rep) const {
+    if (def_levels_read != rep_levels_read) {
         throw parquet_exception::corrupted_file(
-          seastar::format("Unexpected end of dictionary page (expected {} values, got {})", _dict->size(), n_read));
+          seastar::format("Number of definition levels {} does not equal the number of repetition levels {} in batch",
+                          def_levels_read, rep_levels_read));
+    }
+    if (max_def > _def_level) {
+        throw parquet_exception::corrupted_file(
+          seastar::format("Definition level ({}) out of range (0 to {})", max_def, _def_level));
+    }
+    if (max_rep > _rep_level) {
+        throw parquet_exception::corrupted_file(
+          seastar::format("Repetition level ({}) out of range (0 to {})", max_rep, _rep_level));
     }
-    _val_decoder.reset_dict(_dict->data(), _dict->size());
+}
+
+template <format::Type::type T>
+void column_chunk_reader<T>::check_chunk_values(size_t values_read, size_t values_expected) const {
+    if (values_read != values_expected) {
+        throw parquet_exception::corrupted_file(seastar::format(
+          "Number of values in batch {} is less than indicated by def levels {}", values_read, values_expected));
+    }
+}
+
+template <format::Type::type T>
+seastar::future<> column_chunk_reader<T>::load_page(page p) {
+    switch (p.header->type) {
+        case format::PageType::DATA_PAGE:
+            return load_data_page(p).then([this] {
+                select_page_kernel();
+                _initialized = true;
+            });
+        case format::PageType::DATA_PAGE_V2:
+            return load_data_page_v2(p).then([this] {
+                select_page_kernel();
+                _initialized = true;
+            });
+        case format::PageType::DICTIONARY_PAGE:
+            return load_dictionary_page(p);
+        default:;  // Unknown page types are to be skipped
+    }
+    return seastar::make_ready_future<>();
 }
 
 template <format::Type::type T>
@@ -162,25 +251,126 @@ seastar::future<> column_chunk_reader<T>::load_next_page() {
     return _source.next_page().then([this](std::optional<page> p) {
         if (!p) {
             _eof = true;
-        } else {
-            switch (p->header->type) {
-                case format::PageType::DATA_PAGE:
-                    load_data_page(*p);
-                    _initialized = true;
-                    return;
-                case format::PageType::DATA_PAGE_V2:
-                    load_data_page_v2(*p);
-                    _initialized = true;
-                    return;
-                case format::PageType::DICTIONARY_PAGE:
-                    load_dictionary_page(*p);
-                    return;
-                default:;  // Unknown page types are to be skipped
+            return seastar::make_ready_future<>();
+        }
+        return load_page(*p);
+    });
+}
+
+template <format::Type::type T>
+typename column_chunk_reader<T>::row_span column_chunk_reader<T>::find_rows(size_t n) {
+    row_span span;
+    if (_rep_level == 0) {
+        // Every level is a row.
+        span.levels = std::min({n, PREEMPTION_CHECK_INTERVAL, size_t(_rep_decoder.levels_left())});
+        span.rows = span.levels;
+        span.done = span.rows == n;
+        return span;
+    }
+    // Rows begin at repetition level 0. The levels are scanned with a copy of the repetition level decoder,
+    // so that nothing is consumed, including the level which begins the row after the span.
+    level_decoder lookahead = _rep_decoder;
+    uint32_t rep[1024];
+    uint32_t n_read = lookahead.read_batch(std::size(rep), rep);
+    for (; span.levels < n_read; ++span.levels) {
+        if (rep[span.levels] == 0) {
+            if (span.rows == n) {
+                span.done = true;
+                break;
             }
+            ++span.rows;
         }
+    }
+    return span;
+}
+
+template <format::Type::type T>
+typename column_chunk_reader<T>::row_span column_chunk_reader<T>::skip_in_page(size_t n) {
+    row_span progress = find_rows(n);
+    _rep_decoder.skip(progress.levels);
+    uint32_t values_to_skip = 0;
+    uint32_t def_levels_skipped = _def_decoder.skip(progress.levels, _def_level, &values_to_skip);
+    if (def_levels_skipped != progress.levels) {
+        throw parquet_exception::corrupted_file(seastar::format(
+          "Number of definition levels {} does not equal the number of repetition levels {} in skipped batch",
+          def_levels_skipped, progress.levels));
+    }
+    size_t values_skipped = _val_decoder.skip(values_to_skip);
+    if (values_skipped != values_to_skip) {
+        throw parquet_exception::corrupted_file(
+          seastar::format("Number of values in skipped batch {} is less than indicated by def levels {}",
+                          values_skipped, values_to_skip));
+    }
+    return progress;
+}
+
+template <format::Type::type T>
+seastar::future<size_t> column_chunk_reader<T>::skip_next_page(size_t n) {
+    ++_page_ordinal;
+    return _source.next_page().then([this, n](std::optional<page> p) {
+        if (!p) {
+            _eof = true;
+            return seastar::make_ready_future<size_t>(0);
+        }
+        // A data page which holds only skipped rows is dropped without decompressing it.
+        // The number of rows in a page is known up front only in flat columns and in data pages V2.
+        const format::PageHeader& header = *p->header;
+        std::optional<size_t> rows;
+        if (header.type == format::PageType::DATA_PAGE && header.__isset.data_page_header && _rep_level == 0
+            && header.data_page_header.num_values >= 0) {
+            rows = header.data_page_header.num_values;
+        } else if (header.type == format::PageType::DATA_PAGE_V2 && header.__isset.data_page_header_v2
+                   && header.data_page_header_v2.num_rows >= 0) {
+            rows = header.data_page_header_v2.num_rows;
+        }
+        if (rows && *rows <= n) {
+            return seastar::make_ready_future<size_t>(*rows);
+        }
+        return load_page(*p).then([] { return size_t(0); });
     });
 }
 
+template <format::Type::type T>
+seastar::future<size_t> column_chunk_reader<T>::skip_internal(size_t n) {
+    if (_eof || (n == 0 && _rep_level == 0)) {
+        return seastar::make_ready_future<size_t>(0);
+    }
+    if (not _initialized) {
+        return skip_next_page(n).then([this, n](size_t rows_skipped) {
+            return skip_internal(n - rows_skipped).then([rows_skipped](size_t rest) { return rows_skipped + rest; });
+        });
+    }
+    size_t rows_skipped = 0;
+    while (true) {
+        row_span progress = skip_in_page(n - rows_skipped);
+        rows_skipped += progress.rows;
+        if (progress.done) {
+            return seastar::make_ready_future<size_t>(rows_skipped);
+        }
+        if (progress.levels == 0) {
+            // End of page. In nested columns, the last row may continue on the next page.
+            _initialized = false;
+            return skip_internal(n - rows_skipped).then([rows_skipped](size_t rest) { return rows_skipped + rest; });
+        }
+        if (seastar::need_preempt()) {
+            return seastar::yield().then([this, n, rows_skipped] {
+                return skip_internal(n - rows_skipped).then([rows_skipped](size_t rest) {
+                    return rows_skipped + rest;
+                });
+            });
+        }
+    }
+}
+
+template <format::Type::type T>
+seastar::future<size_t> column_chunk_reader<T>::skip(size_t n) {
+    return seastar::futurize_invoke([this, n] { return skip_internal(n); })
+      .handle_exception_type([this](const std::exception& e) {
+          return seastar::make_exception_future<size_t>(
+            parquet_exception(seastar::format("Error while reading page number {}: {}", _page_ordinal, e.what())));
+      });
+}
+
 template class column_chunk_reader<format::Type::INT32>;
 template class column_chunk_reader<format::Type::INT64>;
 template class column_chunk_reader<format::Type::INT96>;
@@ -0,0 +1,285 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+
+#include <parquet4seastar/columnar_reader.hh>
+#include <parquet4seastar/exception.hh>
+
+namespace parquet4seastar {
+
+column_shape column_shape::of(const reader_schema::raw_schema& schema, uint32_t column) {
+    if (column >= schema.leaves.size()) {
+        throw parquet_exception(
+          seastar::format("Column {} out of range (the file has {} columns)", column, schema.leaves.size()));
+    }
+    const reader_schema::raw_node& leaf = *schema.leaves[column];
+    if (leaf.def_level > static_cast<uint32_t>(std::numeric_limits<int16_t>::max())) {
+        throw parquet_exception(
+          seastar::format("Levels greater than {} are not supported", std::numeric_limits<int16_t>::max()));
+    }
+    column_shape shape;
+    shape.max_def_level = leaf.def_level;
+    // Walk down from the root to the leaf.
+    const reader_schema::raw_node* node = &schema.root;
+    uint32_t parent_def_level = node->def_level;
+    for (const std::string& name : leaf.path) {
+        auto child = std::find_if(node->children.begin(), node->children.end(),
+                                  [&name](const reader_schema::raw_node& c) { return c.info.name == name; });
+        assert(child != node->children.end());
+        node = &*child;
+        if (node->info.repetition_type == format::FieldRepetitionType::REPEATED) {
+            shape.lists.push_back({node->def_level, parent_def_level});
+        }
+        parent_def_level = node->def_level;
+    }
+    return shape;
+}
+
+template <format::Type::type T>
+column_batch_reader<T>::column_batch_reader(column_chunk_reader<T>&& source, column_shape shape)
+    : _source{std::move(source)}, _shape{std::move(shape)} {}
+
+template <format::Type::type T>
+seastar::future<column_batch<T>> column_batch_reader<T>::read_batch(size_t n) {
+    _def.clear();
+    _rep.clear();
+    _dense_values.clear();
+    column_batch<T> batch;
+    if (_shape.lists.empty() && _shape.max_def_level == 1) {
+        batch.rows = co_await read_flat_optional(n, batch);
+        co_return batch;
+    }
+    batch.rows = co_await _source.read_rows(n, _def, _rep, _dense_values);
+    if (_shape.lists.empty()) {
+        assemble_flat(batch);
+    } else {
+        assemble_nested(batch);
+    }
+    co_return batch;
+}
+
+// Top-level optional columns are read with a validity bitmap rather than def levels. It becomes the batch's
+// validity as is, and only the values are scattered into their slots.
+template <format::Type::type T>
+seastar::future<size_t> column_batch_reader<T>::read_flat_optional(size_t n, column_batch<T>& batch) {
+    _dense_values.resize(n);
+    size_t slots = 0;
+    size_t values = 0;
+    while (slots < n) {
+        uint8_t* bitmap = batch.validity.prepare_append(n - slots);
+        size_t values_read = 0;
+        size_t slots_read = co_await _source.read_batch_validity(n - slots, bitmap, slots,
+                                                                 _dense_values.data() + values, &values_read);
+        batch.validity.commit_append(slots_read, values_read);
+        if (slots_read == 0) {
+            break;
+        }
+        slots += slots_read;
+        values += values_read;
+    }
+    _dense_values.resize(values);
+    if (values == slots || values == 0) {
+        batch.values = std::move(_dense_values);
+        _dense_values.clear();
+        batch.values.resize(slots);
+        co_return slots;
+    }
+    batch.values.resize(slots);
+    size_t value = 0;
+    for (size_t i = 0; i < slots; ++i) {
+        if (batch.validity[i]) {
+            batch.values[i] = std::move(_dense_values[value++]);
+        }
+    }
+    co_return slots;
+}
+
+template <format::Type::type T>
+void column_batch_reader<T>::assemble_flat(column_batch<T>& batch) {
+    if (!_shape.leaf_nullable()) {
+        // The decoded values are already in the right layout.
+        batch.values = std::move(_dense_values);
+        _dense_values.clear();
+        return;
+    }
+    const size_t n_levels = _def.size();
+    if (_dense_values.size() == n_levels || _dense_values.empty()) {
+        // No nulls, or only nulls, as in batches of all-valid or all-null pages. There is nothing to scatter.
+        const bool valid = !_dense_values.empty();
+        batch.values = std::move(_dense_values);
+        _dense_values.clear();
+        batch.values.resize(n_levels);
+        batch.validity.append(n_levels, valid);
+        return;
+    }
+    const int16_t max_def = _shape.max_def_level;
+    batch.values.resize(n_levels);
+    _valid.resize(n_levels);
+    size_t value = 0;
+    for (size_t i = 0; i < n_levels; ++i) {
+        const bool valid = _def[i] == max_def;
+        _valid[i] = valid;
+        if (valid) {
+            batch.values[i] = std::move(_dense_values[value++]);
+        }
+    }
+    batch.validity.append(_valid.data(), n_levels);
+}
+
+/* Dremel levels to Arrow lists, in one pass over the levels per list level, outermost first.
+ * A list at level k (repetition level k + 1) exists where the enclosing list has an element,
+ * i.e. def >= the enclosing list's def_level. Levels with rep > k + 1 belong to deeper lists.
+ * Among the rest, rep < k + 1 begins a new list, and def >= def_level adds an element to it.
+ * Offsets and validity are written unconditionally and the output position only advances
+ * when a list begins, so the loop body has no data-dependent branches.
+ * A leaf slot exists where the innermost list has an element.
+ */
+template <format::Type::type T>
+void column_batch_reader<T>::assemble_nested(column_batch<T>& batch) {
+    const size_t n_levels = _def.size();
+    const int16_t* def = _def.data();
+    const int16_t* rep = _rep.data();
+    _valid.resize(n_levels);
+    uint8_t* valid = _valid.data();
+    batch.lists.resize(_shape.lists.size());
+    int16_t parent_def_level = 0;
+    for (size_t k = 0; k < _shape.lists.size(); ++k) {
+        const int16_t rep_level = k + 1;
+        const int16_t def_level = _shape.lists[k].def_level;
+        const int16_t null_def_level = _shape.lists[k].null_def_level;
+        list_batch& lists = batch.lists[k];
+        lists.offsets.resize(n_levels + 1);
+        int32_t* offsets = lists.offsets.data();
+        size_t n_lists = 0;
+        int32_t n_elements = 0;
+        for (size_t i = 0; i < n_levels; ++i) {
+            const bool present = (def[i] >= parent_def_level) & (rep[i] <= rep_level);
+            offsets[n_lists] = n_elements;
+            valid[n_lists] = def[i] >= null_def_level;
+            n_lists += present & (rep[i] < rep_level);
+            n_elements += present & (def[i] >= def_level);
+        }
+        offsets[n_lists] = n_elements;
+        lists.offsets.resize(n_lists + 1);
+        if (_shape.list_nullable(k)) {
+            lists.validity.append(valid, n_lists);
+        }
+        parent_def_level = def_level;
+    }
+
+    const int16_t leaf_def_level = _shape.leaf_def_level();
+    const int16_t max_def = _shape.max_def_level;
+    batch.values.resize(n_levels);
+    size_t n_slots = 0;
+    size_t value = 0;
+    for (size_t i = 0; i < n_levels; ++i) {
+        const bool is_valid = def[i] == max_def;
+        valid[n_slots] = is_valid;
+        if (is_valid) {
+            batch.values[n_slots] = std::move(_dense_values[value++]);
+        }
+        n_slots += def[i] >= leaf_def_level;
+    }
+    batch.values.resize(n_slots);
+    if (_shape.leaf_nullable()) {
+        batch.validity.append(valid, n_slots);
+    }
+}
+
+namespace {
+
+template <format::Type::type T>
+seastar::future<column_batch_reader<T>> open_column_batch_reader(file_reader& file, uint32_t row_group,
+                                                                 uint32_t column) {
+    column_shape shape = column_shape::of(file.raw_schema(), column);
+    co_return column_batch_reader<T>{co_await file.open_column_chunk_reader<T>(row_group, column), std::move(shape)};
+}
+
+}  // namespace
+
+seastar::future<columnar_reader> columnar_reader::open(file_reader& file, uint32_t row_group,
+                                                       std::vector<uint32_t> columns) {
+    std::vector<any_column_batch_reader> readers;
+    readers.reserve(columns.size());
+    for (uint32_t column : columns) {
+        if (column >= file.raw_schema().leaves.size()) {
+            throw parquet_exception(seastar::format("Column {} out of range (the file has {} columns)", column,
+                                                    file.raw_schema().leaves.size()));
+        }
+        switch (file.raw_schema().leaves[column]->info.type) {
+            case format::Type::INT32:
+                readers.push_back(co_await open_column_batch_reader<format::Type::INT32>(file, row_group, column));
+                break;
+            case format::Type::INT64:
+                readers.push_back(co_await open_column_batch_reader<format::Type::INT64>(file, row_group, column));
+                break;
+            case format::Type::INT96:
+                readers.push_back(co_await open_column_batch_reader<format::Type::INT96>(file, row_group, column));
+                break;
+            case format::Type::FLOAT:
+                readers.push_back(co_await open_column_batch_reader<format::Type::FLOAT>(file, row_group, column));
+                break;
+            case format::Type::DOUBLE:
+                readers.push_back(co_await open_column_batch_reader<format::Type::DOUBLE>(file, row_group, column));
+                break;
+            case format::Type::BOOLEAN:
+                readers.push_back(co_await open_column_batch_reader<format::Type::BOOLEAN>(file, row_group, column));
+                break;
+            case format::Type::BYTE_ARRAY:
+                readers.push_back(
+                  co_await open_column_batch_reader<format::Type::BYTE_ARRAY>(file, row_group, column));
+                break;
+            case format::Type::FIXED_LEN_BYTE_ARRAY:
+                readers.push_back(
+                  co_await open_column_batch_reader<format::Type::FIXED_LEN_BYTE_ARRAY>(file, row_group, column));
+                break;
+            default:
+                throw parquet_exception::corrupted_file(seastar::format(
+                  "Unknown physical type {} of column {}",
+                  static_cast<int32_t>(file.raw_schema().leaves[column]->info.type), column));
+        }
+    }
+    co_return columnar_reader{std::move(readers)};
+}
+
+seastar::future<std::vector<any_column_batch>> columnar_reader::read_batch(size_t n) {
+    std::vector<any_column_batch> batches;
+    batches.reserve(_readers.size());
+    for (any_column_batch_reader& reader : _readers) {
+        batches.push_back(co_await std::visit(
+          [n](auto& r) {
+              return r.read_batch(n).then([](auto batch) { return any_column_batch{std::move(batch)}; });
+          },
+          reader));
+    }
+    co_return batches;
+}
+
+template class column_batch_reader<format::Type::INT32>;
+template class column_batch_reader<format::Type::INT64>;
+template class column_batch_reader<format::Type::INT96>;
+template class column_batch_reader<format::Type::FLOAT>;
+template class column_batch_reader<format::Type::DOUBLE>;
+template class column_batch_reader<format::Type::BOOLEAN>;
+template class column_batch_reader<format::Type::BYTE_ARRAY>;
+template class column_batch_reader<format::Type::FIXED_LEN_BYTE_ARRAY>;
+
+}  // namespace parquet4seastar
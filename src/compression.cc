@@ -19,36 +19,61 @@
  * Copyright (C) 2020 ScyllaDB
  */
 
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+#include <lz4.h>
 #include <snappy.h>
 #include <zlib.h>
+#ifdef PARQUET4SEASTAR_HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
 
 #include <parquet4seastar/compression.hh>
 #include <parquet4seastar/exception.hh>
 
 namespace parquet4seastar {
 
+bytes compressor::decompress(bytes_view in, bytes&& out) const {
+    size_t n = decompress(in, std::span<byte>(out.data(), out.size()));
+    out.resize(n);
+    return std::move(out);
+}
+
+bytes compressor::compress(bytes_view in, bytes&& out) const {
+    out.resize(max_compressed_size(in.size()));
+    size_t n = compress(in, std::span<byte>(out.data(), out.size()));
+    out.resize(n);
+    return std::move(out);
+}
+
 class uncompressed_compressor final : public compressor
 {
-    bytes decompress(bytes_view in, bytes&& out) const override {
+    size_t decompress(bytes_view in, std::span<byte> out) const override {
         if (out.size() < in.size()) {
             throw parquet_exception::corrupted_file("Uncompression buffer size too small");
         }
-        out.clear();
-        out.insert(out.end(), in.begin(), in.end());
-        return std::move(out);
+        std::copy(in.begin(), in.end(), out.begin());
+        return in.size();
     }
-    bytes compress(bytes_view in, bytes&& out) const override {
-        out.clear();
-        out.reserve(in.size());
-        out.insert(out.end(), in.begin(), in.end());
-        return std::move(out);
+    size_t max_compressed_size(size_t in_size) const override { return in_size; }
+    size_t compress(bytes_view in, std::span<byte> out) const override {
+        if (out.size() < in.size()) {
+            throw parquet_exception("Compression buffer size too small");
+        }
+        std::copy(in.begin(), in.end(), out.begin());
+        return in.size();
     }
     format::CompressionCodec::type type() const override { return format::CompressionCodec::UNCOMPRESSED; }
 };
 
 class snappy_compressor final : public compressor
 {
-    bytes decompress(bytes_view in, bytes&& out) const override {
+    size_t decompress(bytes_view in, std::span<byte> out) const override {
         size_t uncompressed_size;
         const char* in_data = reinterpret_cast<const char*>(in.data());
         if (!snappy::GetUncompressedLength(in_data, in.size(), &uncompressed_size)) {
@@ -57,73 +82,172 @@ class snappy_compressor final : public compressor
         if (out.size() < uncompressed_size) {
             throw parquet_exception::corrupted_file("Uncompression buffer size too small");
         }
-        out.resize(uncompressed_size);
         char* out_data = reinterpret_cast<char*>(out.data());
         if (!snappy::RawUncompress(in_data, in.size(), out_data)) {
             throw parquet_exception("Could not decompress snappy.");
         }
-        return std::move(out);
+        return uncompressed_size;
     }
-    bytes compress(bytes_view in, bytes&& out) const override {
-        out.resize(snappy::MaxCompressedLength(in.size()));
+    size_t max_compressed_size(size_t in_size) const override { return snappy::MaxCompressedLength(in_size); }
+    size_t compress(bytes_view in, std::span<byte> out) const override {
+        if (out.size() < snappy::MaxCompressedLength(in.size())) {
+            throw parquet_exception("Compression buffer size too small");
+        }
         const char* in_data = reinterpret_cast<const char*>(in.data());
         char* out_data = reinterpret_cast<char*>(out.data());
         size_t compressed_size;
         snappy::RawCompress(in_data, in.size(), out_data, &compressed_size);
-        out.resize(compressed_size);
-        return std::move(out);
+        return compressed_size;
     }
     format::CompressionCodec::type type() const override { return format::CompressionCodec::SNAPPY; }
 };
 
-class gzip_compressor final : public compressor
+namespace {
+
+// Determine if this is libz or gzip from header.
+constexpr int ZLIB_DETECT_CODEC = 32;
+// Maximum window size
+constexpr int ZLIB_WINDOW_BITS = 15;
+
+/* Each zlib stream holds a few hundred KiB of state, which is expensive to set up and tear down
+ * for every page. Instead, we keep the streams alive for the lifetime of the thread (i.e. the shard,
+ * since Seastar runs one thread per shard) and only reset them between pages.
+ */
+class zlib_inflate_stream
 {
-    bytes decompress(bytes_view in, bytes&& out) const override {
-        z_stream zs;
-        zs.zalloc = Z_NULL;
-        zs.zfree = Z_NULL;
-        zs.opaque = Z_NULL;
-        zs.avail_in = 0;
-        zs.next_in = Z_NULL;
-
-        // Determine if this is libz or gzip from header.
-        constexpr int DETECT_CODEC = 32;
-        // Maximum window size
-        constexpr int WINDOW_BITS = 15;
-        if (inflateInit2(&zs, DETECT_CODEC | WINDOW_BITS) != Z_OK) {
+    z_stream _zs = {};
+
+   public:
+    zlib_inflate_stream() {
+        if (inflateInit2(&_zs, ZLIB_DETECT_CODEC | ZLIB_WINDOW_BITS) != Z_OK) {
             throw parquet_exception("deflate decompression init failure");
         }
+    }
+    zlib_inflate_stream(const zlib_inflate_stream&) = delete;
+    ~zlib_inflate_stream() { inflateEnd(&_zs); }
+    z_stream& reset() {
+        if (inflateReset(&_zs) != Z_OK) {
+            throw parquet_exception("deflate decompression reset failure");
+        }
+        return _zs;
+    }
+};
+
+class zlib_deflate_stream
+{
+    z_stream _zs = {};
+
+   public:
+    explicit zlib_deflate_stream(int level) {
+        if (deflateInit(&_zs, level) != Z_OK) {
+            throw parquet_exception("deflate compression init failure");
+        }
+    }
+    zlib_deflate_stream(const zlib_deflate_stream&) = delete;
+    ~zlib_deflate_stream() { deflateEnd(&_zs); }
+    z_stream& reset() {
+        if (deflateReset(&_zs) != Z_OK) {
+            throw parquet_exception("deflate compression reset failure");
+        }
+        return _zs;
+    }
+};
 
+z_stream& local_inflate_stream() {
+    static thread_local zlib_inflate_stream stream;
+    return stream.reset();
+}
+
+// Compression levels range from Z_DEFAULT_COMPRESSION (-1) to Z_BEST_COMPRESSION (9).
+z_stream& local_deflate_stream(int level) {
+    static thread_local std::array<std::unique_ptr<zlib_deflate_stream>, Z_BEST_COMPRESSION + 2> streams;
+    std::unique_ptr<zlib_deflate_stream>& stream = streams[level + 1];
+    if (!stream) {
+        stream = std::make_unique<zlib_deflate_stream>(level);
+    }
+    return stream->reset();
+}
+
+#ifdef PARQUET4SEASTAR_HAVE_LIBDEFLATE
+struct libdeflate_decompressor_deleter
+{
+    void operator()(libdeflate_decompressor* d) const { libdeflate_free_decompressor(d); }
+};
+
+libdeflate_decompressor* local_libdeflate_decompressor() {
+    static thread_local std::unique_ptr<libdeflate_decompressor, libdeflate_decompressor_deleter> d{
+      libdeflate_alloc_decompressor()};
+    if (!d) {
+        throw std::bad_alloc();
+    }
+    return d.get();
+}
+
+// libdeflate is a lot faster than zlib, but it only works in one shot, with the full output size known
+// upfront. That's always the case in Parquet. Returns the number of decompressed bytes,
+// or nullopt if libdeflate couldn't handle the input and zlib should be tried instead.
+std::optional<size_t> libdeflate_decompress(bytes_view in, std::span<byte> out) {
+    constexpr byte GZIP_MAGIC[] = {0x1f, 0x8b};
+    bool is_gzip = in.size() >= 2 && in[0] == GZIP_MAGIC[0] && in[1] == GZIP_MAGIC[1];
+    size_t in_consumed;
+    size_t out_size;
+    libdeflate_result res =
+      is_gzip ? libdeflate_gzip_decompress_ex(local_libdeflate_decompressor(), in.data(), in.size(), out.data(),
+                                              out.size(), &in_consumed, &out_size)
+              : libdeflate_zlib_decompress_ex(local_libdeflate_decompressor(), in.data(), in.size(), out.data(),
+                                              out.size(), &in_consumed, &out_size);
+    if (res == LIBDEFLATE_SUCCESS) {
+        return out_size;
+    } else if (res == LIBDEFLATE_INSUFFICIENT_SPACE) {
+        throw parquet_exception::corrupted_file("Decompression buffer size too small");
+    }
+    return std::nullopt;
+}
+#endif
+
+}  // namespace
+
+class gzip_compressor final : public compressor
+{
+    int _level;
+
+   public:
+    explicit gzip_compressor(const compressor_options& options)
+        : _level{options.level.value_or(Z_DEFAULT_COMPRESSION)} {
+        if (_level < Z_DEFAULT_COMPRESSION || _level > Z_BEST_COMPRESSION) {
+            throw parquet_exception(seastar::format("GZIP compression level ({}) out of range ({} to {})", _level,
+                                                    Z_DEFAULT_COMPRESSION, Z_BEST_COMPRESSION));
+        }
+    }
+
+   private:
+    size_t decompress(bytes_view in, std::span<byte> out) const override {
+#ifdef PARQUET4SEASTAR_HAVE_LIBDEFLATE
+        if (auto n = libdeflate_decompress(in, out)) {
+            return *n;
+        }
+#endif
+        z_stream& zs = local_inflate_stream();
         zs.next_in = reinterpret_cast<unsigned char*>(const_cast<byte*>(in.data()));
         zs.avail_in = in.size();
         zs.next_out = reinterpret_cast<unsigned char*>(out.data());
         zs.avail_out = out.size();
 
         auto res = inflate(&zs, Z_FINISH);
-        inflateEnd(&zs);
 
         if (res == Z_STREAM_END) {
-            out.resize(out.size() - zs.avail_out);
+            return out.size() - zs.avail_out;
         } else if (res == Z_BUF_ERROR) {
             throw parquet_exception::corrupted_file("Decompression buffer size too small");
         } else {
             throw parquet_exception("deflate decompression failure");
         }
-        return std::move(out);
     }
-    bytes compress(bytes_view in, bytes&& out) const override {
-        z_stream zs;
-        zs.zalloc = Z_NULL;
-        zs.zfree = Z_NULL;
-        zs.opaque = Z_NULL;
-        zs.avail_in = 0;
-        zs.next_in = Z_NULL;
-
-        if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) {
-            throw parquet_exception("deflate compression init failure");
-        }
-
-        out.resize(deflateBound(&zs, in.size()));
+    size_t max_compressed_size(size_t in_size) const override {
+        return deflateBound(&local_deflate_stream(_level), in_size);
+    }
+    size_t compress(bytes_view in, std::span<byte> out) const override {
+        z_stream& zs = local_deflate_stream(_level);
 
         zs.next_in = reinterpret_cast<unsigned char*>(const_cast<byte*>(in.data()));
         zs.avail_in = in.size();
@@ -131,25 +255,202 @@ class gzip_compressor final : public compressor
         zs.avail_out = out.size();
 
         auto res = deflate(&zs, Z_FINISH);
-        deflateEnd(&zs);
 
         if (res == Z_STREAM_END) {
-            out.resize(out.size() - zs.avail_out);
+            return out.size() - zs.avail_out;
+        } else if (res == Z_OK || res == Z_BUF_ERROR) {
+            throw parquet_exception("Compression buffer size too small");
         } else {
             throw parquet_exception("deflate compression failure");
         }
-        return std::move(out);
     }
     format::CompressionCodec::type type() const override { return format::CompressionCodec::GZIP; }
 };
 
-std::unique_ptr<compressor> compressor::make(format::CompressionCodec::type compression) {
+namespace {
+
+constexpr size_t lz4_max_block_size = static_cast<size_t>(std::numeric_limits<int>::max());
+
+// Returns the number of decompressed bytes, or a negative number if the input is corrupt
+// or doesn't fit in the output.
+int lz4_decompress_block(bytes_view in, byte* out, size_t out_capacity) {
+    // The uncompressed size is always known in Parquet, so we can decompress straight into
+    // the destination. decompress_safe (unlike the deprecated decompress_fast) also guards
+    // against corrupted input overrunning the output.
+    return LZ4_decompress_safe(reinterpret_cast<const char*>(in.data()), reinterpret_cast<char*>(out),
+                               static_cast<int>(in.size()), static_cast<int>(out_capacity));
+}
+
+size_t lz4_max_compressed_size(size_t in_size) {
+    if (in_size > static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+        throw parquet_exception("LZ4 block too large");
+    }
+    return LZ4_compressBound(static_cast<int>(in_size));
+}
+
+size_t lz4_compress_block(bytes_view in, std::span<byte> out) {
+    if (in.size() > static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+        throw parquet_exception("LZ4 block too large");
+    }
+    int capacity = static_cast<int>(std::min(out.size(), lz4_max_block_size));
+    int n = LZ4_compress_default(reinterpret_cast<const char*>(in.data()), reinterpret_cast<char*>(out.data()),
+                                 static_cast<int>(in.size()), capacity);
+    if (n <= 0) {
+        throw parquet_exception("LZ4 compression failure or compression buffer size too small");
+    }
+    return n;
+}
+
+}  // namespace
+
+class lz4_raw_compressor final : public compressor
+{
+    size_t decompress(bytes_view in, std::span<byte> out) const override {
+        if (in.size() > lz4_max_block_size || out.size() > lz4_max_block_size) {
+            throw parquet_exception("LZ4 block too large");
+        }
+        int n = lz4_decompress_block(in, out.data(), out.size());
+        if (n < 0) {
+            throw parquet_exception::corrupted_file("Corrupt LZ4 data or decompression buffer size too small");
+        }
+        return n;
+    }
+    size_t max_compressed_size(size_t in_size) const override { return lz4_max_compressed_size(in_size); }
+    size_t compress(bytes_view in, std::span<byte> out) const override { return lz4_compress_block(in, out); }
+    format::CompressionCodec::type type() const override { return format::CompressionCodec::LZ4_RAW; }
+};
+
+/* The deprecated LZ4 codec. Parquet-mr (via Hadoop) writes it as a sequence of blocks, each prefixed
+ * with its big-endian uncompressed and compressed sizes. Some older writers (e.g. parquet-cpp) wrote
+ * plain LZ4 blocks instead, so if the input doesn't parse as Hadoop-framed, we fall back to raw LZ4.
+ * We always write the Hadoop framing, like Arrow does.
+ */
+class lz4_hadoop_compressor final : public compressor
+{
+    static constexpr size_t PREFIX_SIZE = 2 * sizeof(uint32_t);
+
+    static uint32_t read_be32(const byte* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+    static void write_be32(byte* p, uint32_t v) {
+        p[0] = static_cast<byte>(v >> 24);
+        p[1] = static_cast<byte>(v >> 16);
+        p[2] = static_cast<byte>(v >> 8);
+        p[3] = static_cast<byte>(v);
+    }
+    // Returns the number of decompressed bytes, or nullopt if the input is not Hadoop-framed.
+    static std::optional<size_t> try_decompress_hadoop(bytes_view in, std::span<byte> out) {
+        size_t out_offset = 0;
+        while (in.size() > 0) {
+            if (in.size() < PREFIX_SIZE) {
+                return std::nullopt;
+            }
+            size_t expected_decompressed_size = read_be32(in.data());
+            size_t expected_compressed_size = read_be32(in.data() + sizeof(uint32_t));
+            in.remove_prefix(PREFIX_SIZE);
+            if (expected_compressed_size > in.size() || expected_decompressed_size > out.size() - out_offset) {
+                return std::nullopt;
+            }
+            int n = lz4_decompress_block(in.substr(0, expected_compressed_size), out.data() + out_offset,
+                                         expected_decompressed_size);
+            if (n < 0 || static_cast<size_t>(n) != expected_decompressed_size) {
+                return std::nullopt;
+            }
+            in.remove_prefix(expected_compressed_size);
+            out_offset += expected_decompressed_size;
+        }
+        return out_offset;
+    }
+
+    size_t decompress(bytes_view in, std::span<byte> out) const override {
+        if (in.size() > lz4_max_block_size || out.size() > lz4_max_block_size) {
+            throw parquet_exception("LZ4 block too large");
+        }
+        if (auto n = try_decompress_hadoop(in, out)) {
+            return *n;
+        }
+        int n = lz4_decompress_block(in, out.data(), out.size());
+        if (n < 0) {
+            throw parquet_exception::corrupted_file("Corrupt LZ4 data or decompression buffer size too small");
+        }
+        return n;
+    }
+    size_t max_compressed_size(size_t in_size) const override {
+        return PREFIX_SIZE + lz4_max_compressed_size(in_size);
+    }
+    size_t compress(bytes_view in, std::span<byte> out) const override {
+        if (out.size() < PREFIX_SIZE) {
+            throw parquet_exception("Compression buffer size too small");
+        }
+        size_t n = lz4_compress_block(in, out.subspan(PREFIX_SIZE));
+        write_be32(out.data(), static_cast<uint32_t>(in.size()));
+        write_be32(out.data() + sizeof(uint32_t), static_cast<uint32_t>(n));
+        return PREFIX_SIZE + n;
+    }
+    format::CompressionCodec::type type() const override { return format::CompressionCodec::LZ4; }
+};
+
+class brotli_compressor final : public compressor
+{
+    int _quality;
+    int _window_bits;
+
+   public:
+    explicit brotli_compressor(const compressor_options& options)
+        : _quality{options.level.value_or(BROTLI_DEFAULT_QUALITY)},
+          _window_bits{options.window_bits.value_or(BROTLI_DEFAULT_WINDOW)} {
+        if (_quality < BROTLI_MIN_QUALITY || _quality > BROTLI_MAX_QUALITY) {
+            throw parquet_exception(seastar::format("Brotli quality ({}) out of range ({} to {})", _quality,
+                                                    BROTLI_MIN_QUALITY, BROTLI_MAX_QUALITY));
+        }
+        if (_window_bits < BROTLI_MIN_WINDOW_BITS || _window_bits > BROTLI_MAX_WINDOW_BITS) {
+            throw parquet_exception(seastar::format("Brotli window bits ({}) out of range ({} to {})", _window_bits,
+                                                    BROTLI_MIN_WINDOW_BITS, BROTLI_MAX_WINDOW_BITS));
+        }
+    }
+
+   private:
+    size_t decompress(bytes_view in, std::span<byte> out) const override {
+        size_t out_size = out.size();
+        auto res = BrotliDecoderDecompress(in.size(), in.data(), &out_size, out.data());
+        if (res != BROTLI_DECODER_RESULT_SUCCESS) {
+            // The one-shot decoder doesn't distinguish between the two.
+            throw parquet_exception::corrupted_file("Corrupt brotli data or decompression buffer size too small");
+        }
+        return out_size;
+    }
+    size_t max_compressed_size(size_t in_size) const override {
+        size_t max_size = BrotliEncoderMaxCompressedSize(in_size);
+        if (max_size == 0) {
+            throw parquet_exception("Brotli input too large");
+        }
+        return max_size;
+    }
+    size_t compress(bytes_view in, std::span<byte> out) const override {
+        size_t out_size = out.size();
+        if (!BrotliEncoderCompress(_quality, _window_bits, BROTLI_MODE_GENERIC, in.size(), in.data(), &out_size,
+                                   out.data())) {
+            throw parquet_exception("brotli compression failure or compression buffer size too small");
+        }
+        return out_size;
+    }
+    format::CompressionCodec::type type() const override { return format::CompressionCodec::BROTLI; }
+};
+
+std::unique_ptr<compressor> compressor::make(format::CompressionCodec::type compression,
+                                             const compressor_options& options) {
     if (compression == format::CompressionCodec::UNCOMPRESSED) {
         return std::make_unique<uncompressed_compressor>();
     } else if (compression == format::CompressionCodec::GZIP) {
-        return std::make_unique<gzip_compressor>();
+        return std::make_unique<gzip_compressor>(options);
     } else if (compression == format::CompressionCodec::SNAPPY) {
         return std::make_unique<snappy_compressor>();
+    } else if (compression == format::CompressionCodec::LZ4_RAW) {
+        return std::make_unique<lz4_raw_compressor>();
+    } else if (compression == format::CompressionCodec::LZ4) {
+        return std::make_unique<lz4_hadoop_compressor>();
+    } else if (compression == format::CompressionCodec::BROTLI) {
+        return std::make_unique<brotli_compressor>(options);
     } else {
         throw parquet_exception(seastar::format("Unsupported compression ({})", static_cast<int32_t>(compression)));
     }
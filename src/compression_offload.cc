@@ -0,0 +1,125 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/compression_offload.hh>
+#include <parquet4seastar/exception.hh>
+#include <seastar/core/alien.hh>
+#include <seastar/core/reactor.hh>
+#include <seastar/core/smp.hh>
+
+namespace parquet4seastar {
+
+compression_offload::compression_offload(compression_offload_options options)
+    : _options{options},
+      _alien{seastar::engine().alien()},
+      _shard{seastar::this_shard_id()},
+      _queue_slots{options.max_queued} {
+    if (_options.worker_threads == 0 || _options.max_queued == 0) {
+        throw parquet_exception("compression_offload needs at least one worker thread and one queue slot");
+    }
+    _workers.reserve(_options.worker_threads);
+    for (size_t i = 0; i < _options.worker_threads; ++i) {
+        _workers.emplace_back([this] { worker_loop(); });
+    }
+}
+
+compression_offload::~compression_offload() {
+    assert(_jobs.empty());
+    join_workers();
+}
+
+void compression_offload::worker_loop() {
+    while (true) {
+        job j;
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _cv.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+            if (_jobs.empty()) {
+                return;
+            }
+            j = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+        size_t result = 0;
+        std::exception_ptr ex;
+        try {
+            result = j.work();
+        } catch (...) {
+            ex = std::current_exception();
+        }
+        seastar::alien::run_on(_alien, _shard, [done = j.done, result, ex]() noexcept {
+            if (ex) {
+                done->set_exception(ex);
+            } else {
+                done->set_value(result);
+            }
+        });
+    }
+}
+
+void compression_offload::join_workers() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _stopping = true;
+    }
+    _cv.notify_all();
+    for (std::thread& t : _workers) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+}
+
+seastar::future<size_t> compression_offload::submit(std::function<size_t()> work) {
+    // The semaphore bounds the queue, which provides backpressure to the submitters.
+    auto units = co_await seastar::get_units(_queue_slots, 1);
+    seastar::promise<size_t> done;
+    seastar::future<size_t> result = done.get_future();
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _jobs.push_back(job{std::move(work), &done});
+    }
+    _cv.notify_one();
+    co_return co_await std::move(result);
+}
+
+seastar::future<size_t> compression_offload::decompress(const compressor& c, bytes_view in, std::span<byte> out) {
+    if (!should_offload(out.size())) {
+        return seastar::futurize_invoke([&c, in, out] { return c.decompress(in, out); });
+    }
+    return submit([&c, in, out] { return c.decompress(in, out); });
+}
+
+seastar::future<size_t> compression_offload::compress(const compressor& c, bytes_view in, std::span<byte> out) {
+    if (!should_offload(in.size())) {
+        return seastar::futurize_invoke([&c, in, out] { return c.compress(in, out); });
+    }
+    return submit([&c, in, out] { return c.compress(in, out); });
+}
+
+seastar::future<> compression_offload::stop() {
+    // Once all slots are ours, no job is queued or running, and all results have been delivered.
+    co_await _queue_slots.wait(_options.max_queued);
+    join_workers();
+    _queue_slots.signal(_options.max_queued);
+}
+
+}  // namespace parquet4seastar
@@ -23,10 +23,47 @@
 
 namespace parquet4seastar {
 
+namespace {
+
+// If RLE-encoded levels begin with a repeated run of at least num_values levels, return the level of the run.
+// Most pages of optional columns without nulls (and of nested columns without lists) are a single run.
+std::optional<uint32_t> single_run_level(bytes_view levels, uint32_t bit_width, uint32_t num_values) {
+    // The run header: ULEB128 of (count << 1 | is_literal).
+    uint32_t header = 0;
+    size_t pos = 0;
+    for (int shift = 0;; shift += 7) {
+        if (pos == levels.size() || shift > 28) {
+            return std::nullopt;
+        }
+        uint8_t byte = levels[pos++];
+        header |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    if ((header & 1) || (header >> 1) < num_values) {
+        return std::nullopt;
+    }
+    // The repeated level, little endian, in as few bytes as the bit width needs.
+    size_t level_bytes = (bit_width + 7) / 8;
+    if (levels.size() - pos < level_bytes) {
+        return std::nullopt;
+    }
+    uint32_t level = 0;
+    for (size_t i = 0; i < level_bytes; ++i) {
+        level |= static_cast<uint32_t>(levels[pos + i]) << (8 * i);
+    }
+    return level;
+}
+
+}  // namespace
+
 size_t level_decoder::reset_v1(bytes_view buffer, format::Encoding::type encoding, uint32_t num_values) {
     _num_values = num_values;
     _values_read = 0;
+    _constant_level.reset();
     if (_bit_width == 0) {
+        _constant_level = 0;
         return 0;
     }
     if (encoding == format::Encoding::RLE) {
@@ -44,6 +81,7 @@ size_t level_decoder::reset_v1(bytes_view buffer, format::Encoding::type encodin
               seastar::format("End of page while reading levels (needed {}B, got {}B)", len, buffer.size()));
         }
         _decoder = RleDecoder{buffer.data() + 4, len, static_cast<int>(_bit_width)};
+        _constant_level = single_run_level(buffer.substr(4, len), _bit_width, num_values);
         return 4 + len;
     } else if (encoding == format::Encoding::BIT_PACKED) {
         uint64_t bit_len = static_cast<uint64_t>(num_values) * _bit_width;
@@ -70,6 +108,85 @@ void level_decoder::reset_v2(bytes_view encoded_levels, uint32_t num_values) {
           seastar::format("Levels length exceeds int ({}B)", encoded_levels.size()));
     }
     _decoder = RleDecoder{encoded_levels.data(), static_cast<int>(encoded_levels.size()), static_cast<int>(_bit_width)};
+    _constant_level = _bit_width == 0 ? 0 : single_run_level(encoded_levels, _bit_width, num_values);
+}
+
+uint32_t level_decoder::read_bitmap(uint32_t n, BitmapWriter& out, uint32_t* set_count, uint64_t* max_level) {
+    assert(_bit_width == 1);
+    n = std::min(n, _num_values - _values_read);
+    if (_constant_level) {
+        out.PutRun(*_constant_level & 1, n);
+        *set_count += (*_constant_level & 1) * n;
+        *max_level = std::max<uint64_t>(*max_level, *_constant_level);
+        _values_read += n;
+        return n;
+    }
+    uint32_t n_read = std::visit(overloaded{
+                                   [n, &out, set_count](BitReader& r) -> uint32_t {
+                                       // BIT_PACKED levels have no runs. Unpack them 32 at a time.
+                                       uint32_t completed = 0;
+                                       while (completed < n) {
+                                           int chunk = std::min<uint32_t>(n - completed, 32);
+                                           uint32_t word = 0;
+                                           if (!r.GetValue(chunk, &word)) {
+                                               break;
+                                           }
+                                           out.Put(word, chunk);
+                                           *set_count += __builtin_popcount(word);
+                                           completed += chunk;
+                                       }
+                                       return completed;
+                                   },
+                                   [n, &out, set_count, max_level](RleDecoder& r) -> uint32_t {
+                                       return r.GetBitmap(&out, n, set_count, max_level);
+                                   },
+                                 },
+                                 _decoder);
+    _values_read += n_read;
+    return n_read;
+}
+
+uint32_t level_decoder::skip(uint32_t n, uint32_t level, uint32_t* matches) {
+    n = std::min(n, _num_values - _values_read);
+    if (_constant_level) {
+        if (matches && level == *_constant_level) {
+            *matches += n;
+        }
+        _values_read += n;
+        return n;
+    }
+    uint32_t n_skipped = std::visit(overloaded{
+                                      [this, n, level, matches](BitReader& r) -> uint32_t {
+                                          if (!matches) {
+                                              return r.Skip(_bit_width, n);
+                                          }
+                                          // BIT_PACKED has no runs, so counting requires decoding.
+                                          uint32_t buf[256];
+                                          uint32_t completed = 0;
+                                          while (completed < n) {
+                                              uint32_t n_to_read = std::min<uint32_t>(n - completed, std::size(buf));
+                                              uint32_t n_read = r.GetBatch(_bit_width, buf, n_to_read);
+                                              *matches += std::count(buf, buf + n_read, level);
+                                              completed += n_read;
+                                              if (n_read < n_to_read) {
+                                                  break;
+                                              }
+                                          }
+                                          return completed;
+                                      },
+                                      [n, level, matches](RleDecoder& r) -> uint32_t {
+                                          if (!matches) {
+                                              return r.Skip(n);
+                                          }
+                                          int n_matches = 0;
+                                          uint32_t n_skipped = r.Skip(n, level, &n_matches);
+                                          *matches += n_matches;
+                                          return n_skipped;
+                                      },
+                                    },
+                                    _decoder);
+    _values_read += n_skipped;
+    return n_skipped;
 }
 
 template <format::Type::type ParquetType>
@@ -81,6 +198,7 @@ class plain_decoder_trivial final : public decoder<ParquetType>
     using typename decoder<ParquetType>::output_type;
     void reset(bytes_view data) override;
     size_t read_batch(size_t n, output_type out[]) override;
+    size_t skip(size_t n) override;
 };
 
 class plain_decoder_boolean final : public decoder<format::Type::BOOLEAN>
@@ -91,28 +209,45 @@ class plain_decoder_boolean final : public decoder<format::Type::BOOLEAN>
     using typename decoder<format::Type::BOOLEAN>::output_type;
     void reset(bytes_view data) override;
     size_t read_batch(size_t n, output_type out[]) override;
+    size_t skip(size_t n) override;
 };
 
 class plain_decoder_byte_array final : public decoder<format::Type::BYTE_ARRAY>
 {
+    // The rest of the page. It is copied to _buffer only when values are returned as temporary_buffers,
+    // which share _buffer. Contiguous output is copied straight from the page.
+    bytes_view _data;
     seastar::temporary_buffer<uint8_t> _buffer;
+    bool _copied = false;
+
+    bool next(bytes_view& value);
+    template <typename OffsetT>
+    size_t read_contiguous_impl(size_t n, byte_array_arena<OffsetT>& out);
 
    public:
     using typename decoder<format::Type::BYTE_ARRAY>::output_type;
     void reset(bytes_view data) override;
     size_t read_batch(size_t n, output_type out[]) override;
+    size_t skip(size_t n) override;
+    size_t read_contiguous(size_t n, byte_array_arena<int32_t>& out) override { return read_contiguous_impl(n, out); }
+    size_t read_contiguous(size_t n, byte_array_arena<int64_t>& out) override { return read_contiguous_impl(n, out); }
 };
 
 class plain_decoder_fixed_len_byte_array final : public decoder<format::Type::FIXED_LEN_BYTE_ARRAY>
 {
     size_t _fixed_len;
+    // As in plain_decoder_byte_array, the page is copied only for values returned as temporary_buffers.
+    bytes_view _data;
     seastar::temporary_buffer<uint8_t> _buffer;
+    bool _copied = false;
 
    public:
     using typename decoder<format::Type::FIXED_LEN_BYTE_ARRAY>::output_type;
     explicit plain_decoder_fixed_len_byte_array(size_t fixed_len = 0) : _fixed_len(fixed_len) {}
     void reset(bytes_view data) override;
     size_t read_batch(size_t n, output_type out[]) override;
+    size_t skip(size_t n) override;
+    size_t read_fixed(size_t n, uint8_t out[]) override;
 };
 
 template <format::Type::type ParquetType>
@@ -122,14 +257,41 @@ class dict_decoder final : public decoder<ParquetType>
     using typename decoder<ParquetType>::output_type;
 
    private:
-    output_type* _dict;
-    size_t _dict_size;
+    static constexpr bool by_value = std::is_trivially_copyable_v<output_type>;
+    output_type* _dict = nullptr;
+    size_t _dict_size = 0;
+    // Byte array entries as plain views, gathered from by read_contiguous without sharing
+    // (and touching the refcount of) a temporary_buffer per value.
+    std::vector<bytes_view> _views;
     RleDecoder _rle_decoder;
+    void check_index(uint64_t max_index) const {
+        if (max_index >= _dict_size) {
+            throw parquet_exception::corrupted_file(
+              seastar::format("Dict index exceeds dict size (dict size = {}, index = {})", _dict_size, max_index));
+        }
+    }
 
    public:
-    explicit dict_decoder(output_type dict[], size_t dict_size) : _dict(dict), _dict_size(dict_size){};
+    explicit dict_decoder(output_type dict[], size_t dict_size) { reset_dict(dict, dict_size); }
+    void reset_dict(output_type dict[], size_t dict_size) override {
+        _dict = dict;
+        _dict_size = dict_size;
+        if constexpr (!by_value) {
+            _views.resize(dict_size);
+            for (size_t i = 0; i < dict_size; ++i) {
+                _views[i] = bytes_view{dict[i].get(), dict[i].size()};
+            }
+        }
+    }
     void reset(bytes_view data) override;
     size_t read_batch(size_t n, output_type out[]) override;
+    size_t skip(size_t n) override;
+    size_t read_indices(size_t n, uint32_t out[]);
+    size_t read_fixed(size_t n, uint8_t out[]) override;
+    template <typename OffsetT>
+    size_t read_contiguous_impl(size_t n, byte_array_arena<OffsetT>& out);
+    size_t read_contiguous(size_t n, byte_array_arena<int32_t>& out) override { return read_contiguous_impl(n, out); }
+    size_t read_contiguous(size_t n, byte_array_arena<int64_t>& out) override { return read_contiguous_impl(n, out); }
 };
 
 class rle_decoder_boolean final : public decoder<format::Type::BOOLEAN>
@@ -140,6 +302,7 @@ class rle_decoder_boolean final : public decoder<format::Type::BOOLEAN>
     using typename decoder<format::Type::BOOLEAN>::output_type;
     void reset(bytes_view data) override;
     size_t read_batch(size_t n, output_type out[]) override;
+    size_t skip(size_t n) override;
 };
 
 template <format::Type::type ParquetType>
@@ -256,26 +419,72 @@ class delta_binary_packed_decoder final : public decoder<ParquetType>
 
 class delta_length_byte_array_decoder final : public decoder<format::Type::BYTE_ARRAY>
 {
-    seastar::temporary_buffer<byte> _values;
+    // The values, in place in the page. As in plain_decoder_byte_array, they are copied to _buffer only
+    // when they are returned as temporary_buffers.
+    bytes_view _values;
+    seastar::temporary_buffer<byte> _buffer;
+    bool _copied = false;
+    // Reused between pages, along with the decoder.
     std::vector<int32_t> _lengths;
-    size_t _current_idx;
+    size_t _current_idx = 0;
     static constexpr size_t BATCH_SIZE = 1000;
 
    public:
     using typename decoder<format::Type::BYTE_ARRAY>::output_type;
-    size_t read_batch(size_t n, output_type out[]) override {
+    // The number of values in the page.
+    size_t size() const { return _lengths.size(); }
+    // Consume the next n values (fewer at the end of data). Point lengths at their lengths, and values at their
+    // data, which is back to back. Return the number of values consumed.
+    size_t next_values(size_t n, const int32_t*& lengths, bytes_view& values) {
         n = std::min(n, _lengths.size() - _current_idx);
+        lengths = _lengths.data() + _current_idx;
+        size_t total_len = 0;
         for (size_t i = 0; i < n; ++i) {
-            uint32_t len = _lengths[_current_idx];
-            if (len > _values.size()) {
-                throw parquet_exception("Unexpected end of values in DELTA_LENGTH_BYTE_ARRAY");
+            if (lengths[i] < 0) {
+                throw parquet_exception("Negative length in DELTA_LENGTH_BYTE_ARRAY");
             }
-            out[i] = _values.share(0, len);
-            _values.trim_front(len);
-            ++_current_idx;
+            total_len += lengths[i];
+        }
+        if (total_len > _values.size()) {
+            throw parquet_exception("Unexpected end of values in DELTA_LENGTH_BYTE_ARRAY");
         }
+        values = _values.substr(0, total_len);
+        _values.remove_prefix(total_len);
+        _current_idx += n;
         return n;
     }
+    size_t read_batch(size_t n, output_type out[]) override {
+        if (!_copied) {
+            _buffer = seastar::temporary_buffer<byte>(_values.data(), _values.size());
+            _values = bytes_view{_buffer.get(), _buffer.size()};
+            _copied = true;
+        }
+        const int32_t* lengths;
+        bytes_view values;
+        n = next_values(n, lengths, values);
+        size_t offset = values.data() - _buffer.get();
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = _buffer.share(offset, lengths[i]);
+            offset += lengths[i];
+        }
+        return n;
+    }
+    size_t skip(size_t n) override {
+        const int32_t* lengths;
+        bytes_view values;
+        return next_values(n, lengths, values);
+    }
+    template <typename OffsetT>
+    size_t read_contiguous_impl(size_t n, byte_array_arena<OffsetT>& out) {
+        // The values are already back to back, so they are copied at once.
+        const int32_t* lengths;
+        bytes_view values;
+        n = next_values(n, lengths, values);
+        out.append(values.data(), lengths, n);
+        return n;
+    }
+    size_t read_contiguous(size_t n, byte_array_arena<int32_t>& out) override { return read_contiguous_impl(n, out); }
+    size_t read_contiguous(size_t n, byte_array_arena<int64_t>& out) override { return read_contiguous_impl(n, out); }
     void reset(bytes_view data) override {
         delta_binary_packed_decoder<format::Type::INT32> _len_decoder;
         _len_decoder.reset(data);
@@ -294,71 +503,155 @@ class delta_length_byte_array_decoder final : public decoder<format::Type::BYTE_
 
         size_t len_bytes = data.size() - _len_decoder.bytes_left();
         data.remove_prefix(len_bytes);
-        _values = seastar::temporary_buffer<byte>(data.data(), data.size());
+        _values = data;
+        _buffer = {};
+        _copied = false;
         _current_idx = 0;
     }
 };
 
+/* Values are rebuilt from the prefix they share with the previous value and their own suffix.
+ * The suffixes are a DELTA_LENGTH_BYTE_ARRAY, read in place from the page. Values are rebuilt a block at
+ * a time, straight into their destination: an arena, or a single buffer shared by the temporary_buffers
+ * of the block. The prefix of a value is copied from the previous value in the same destination,
+ * so only the last value of a block is kept aside, for the next block.
+ */
 class delta_byte_array_decoder final : public decoder<format::Type::BYTE_ARRAY>
 {
-    using tb = seastar::temporary_buffer<byte>;
-    std::vector<tb> _suffixes;
-    std::vector<int32_t> _lengths;
-    bytes _last_string;
-    size_t _current_idx;
+    // The prefix lengths are decoded up front, since the suffixes start where they end.
+    // Reused between pages, along with the decoder.
+    std::vector<int32_t> _prefix_lengths;
+    size_t _current_idx = 0;
+    delta_length_byte_array_decoder _suffixes;
+    bytes _last_value;
     static constexpr size_t BATCH_SIZE = 1000;
+    static constexpr size_t BLOCK_SIZE = 256;
+
+    struct block
+    {
+        size_t n = 0;
+        const int32_t* prefix_lengths;
+        const int32_t* suffix_lengths;
+        bytes_view suffixes;
+        size_t total_size = 0;
+    };
+    // Consume the next n (up to BLOCK_SIZE) values. Check their prefix lengths, and write their lengths to lengths.
+    block next_block(size_t n, int32_t lengths[]) {
+        block b;
+        b.prefix_lengths = _prefix_lengths.data() + _current_idx;
+        b.n = _suffixes.next_values(n, b.suffix_lengths, b.suffixes);
+        size_t previous_length = _last_value.size();
+        for (size_t i = 0; i < b.n; ++i) {
+            if (b.prefix_lengths[i] < 0 || static_cast<size_t>(b.prefix_lengths[i]) > previous_length) {
+                throw parquet_exception("Invalid prefix length in DELTA_BYTE_ARRAY");
+            }
+            lengths[i] = b.prefix_lengths[i] + b.suffix_lengths[i];
+            b.total_size += lengths[i];
+            previous_length = lengths[i];
+        }
+        _current_idx += b.n;
+        return b;
+    }
+    // Write the values of b back to back to out, and keep the last one for the next block.
+    void write_block(const block& b, const int32_t lengths[], uint8_t out[]) {
+        if (b.total_size == 0) {
+            _last_value.clear();
+            return;
+        }
+        const uint8_t* previous = _last_value.data();
+        const uint8_t* suffix = b.suffixes.data();
+        for (size_t i = 0; i < b.n; ++i) {
+            std::memcpy(out, previous, b.prefix_lengths[i]);
+            std::memcpy(out + b.prefix_lengths[i], suffix, b.suffix_lengths[i]);
+            suffix += b.suffix_lengths[i];
+            previous = out;
+            out += lengths[i];
+        }
+        _last_value.assign(previous, lengths[b.n - 1]);
+    }
+    template <typename OffsetT>
+    size_t read_contiguous_impl(size_t n, byte_array_arena<OffsetT>& out) {
+        std::array<int32_t, BLOCK_SIZE> lengths;
+        size_t completed = 0;
+        while (completed < n) {
+            block b = next_block(std::min(n - completed, BLOCK_SIZE), lengths.data());
+            if (b.n == 0) {
+                break;
+            }
+            write_block(b, lengths.data(), out.append_uninitialized(lengths.data(), b.n));
+            completed += b.n;
+        }
+        return completed;
+    }
 
    public:
     using typename decoder<format::Type::BYTE_ARRAY>::output_type;
     size_t read_batch(size_t n, output_type out[]) override {
-        n = std::min(n, _suffixes.size() - _current_idx);
-        for (size_t i = 0; i < n; ++i) {
-            uint32_t prefix_len = _lengths[i];
-            const tb& suffix = _suffixes[i];
-            if (prefix_len > _last_string.size()) {
-                throw parquet_exception("Invalid prefix length in DELTA_BYTE_ARRAY");
+        std::array<int32_t, BLOCK_SIZE> lengths;
+        size_t completed = 0;
+        while (completed < n) {
+            block b = next_block(std::min(n - completed, BLOCK_SIZE), lengths.data());
+            if (b.n == 0) {
+                break;
+            }
+            seastar::temporary_buffer<byte> values(b.total_size);
+            write_block(b, lengths.data(), values.get_write());
+            size_t offset = 0;
+            for (size_t i = 0; i < b.n; ++i) {
+                out[completed + i] = values.share(offset, lengths[i]);
+                offset += lengths[i];
             }
-            out[i] = tb(prefix_len + suffix.size());
-            std::copy_n(_last_string.begin(), prefix_len, out[i].get_write());
-            std::copy(suffix.begin(), suffix.end(), out[i].get_write() + prefix_len);
-            _last_string.resize(prefix_len);
-            _last_string.insert(_last_string.end(), suffix.begin(), suffix.end());
+            completed += b.n;
         }
-        return n;
+        return completed;
+    }
+    size_t skip(size_t n) override {
+        // Skipped values are not written anywhere, but the last one is still needed for the next value.
+        std::array<int32_t, BLOCK_SIZE> lengths;
+        size_t completed = 0;
+        while (completed < n) {
+            block b = next_block(std::min(n - completed, BLOCK_SIZE), lengths.data());
+            if (b.n == 0) {
+                break;
+            }
+            const uint8_t* suffix = b.suffixes.data();
+            for (size_t i = 0; i < b.n; ++i) {
+                _last_value.resize(b.prefix_lengths[i]);
+                _last_value.append(suffix, b.suffix_lengths[i]);
+                suffix += b.suffix_lengths[i];
+            }
+            completed += b.n;
+        }
+        return completed;
     }
+    size_t read_contiguous(size_t n, byte_array_arena<int32_t>& out) override { return read_contiguous_impl(n, out); }
+    size_t read_contiguous(size_t n, byte_array_arena<int64_t>& out) override { return read_contiguous_impl(n, out); }
     void reset(bytes_view data) override {
         delta_binary_packed_decoder<format::Type::INT32> _len_decoder;
-        delta_length_byte_array_decoder _suffix_decoder;
 
         _len_decoder.reset(data);
         size_t lengths_read = 0;
         while (true) {
-            _lengths.resize(lengths_read + BATCH_SIZE);
-            int32_t* output = _lengths.data() + _lengths.size() - BATCH_SIZE;
+            _prefix_lengths.resize(lengths_read + BATCH_SIZE);
+            int32_t* output = _prefix_lengths.data() + _prefix_lengths.size() - BATCH_SIZE;
             size_t n_read = _len_decoder.read_batch(BATCH_SIZE, output);
             if (n_read == 0) {
                 break;
             }
             lengths_read += n_read;
         }
-        _lengths.resize(lengths_read);
+        _prefix_lengths.resize(lengths_read);
 
         size_t len_bytes = data.size() - _len_decoder.bytes_left();
         data.remove_prefix(len_bytes);
 
-        _suffix_decoder.reset(data);
-        size_t suffixes_read = 0;
-        while (true) {
-            _suffixes.resize(suffixes_read + BATCH_SIZE);
-            tb* output = _suffixes.data() + _suffixes.size() - BATCH_SIZE;
-            size_t n_read = _suffix_decoder.read_batch(BATCH_SIZE, output);
-            if (n_read == 0) {
-                break;
-            }
-            suffixes_read += n_read;
+        _suffixes.reset(data);
+        if (_suffixes.size() != _prefix_lengths.size()) {
+            throw parquet_exception::corrupted_file(seastar::format(
+              "Number of prefix lengths {} does not equal the number of suffixes {} in DELTA_BYTE_ARRAY",
+              _prefix_lengths.size(), _suffixes.size()));
         }
-        _suffixes.resize(suffixes_read);
-
+        _last_value.clear();
         _current_idx = 0;
     }
 };
@@ -386,6 +679,11 @@ class byte_stream_split_decoder final : public decoder<ParquetType>
         }
         return n;
     }
+    size_t skip(size_t n) override {
+        n = std::min(n, _total_values - _current_idx);
+        _current_idx += n;
+        return n;
+    }
     void reset(bytes_view data) override {
         if (data.size() % sizeof(output_type) != 0) {
             throw parquet_exception(
@@ -408,13 +706,15 @@ void plain_decoder_boolean::reset(bytes_view data) {
 }
 
 void plain_decoder_byte_array::reset(bytes_view data) {
-    _buffer = seastar::temporary_buffer<uint8_t>(data.size());
-    std::memcpy(_buffer.get_write(), data.data(), data.size());
+    _data = data;
+    _buffer = {};
+    _copied = false;
 }
 
 void plain_decoder_fixed_len_byte_array::reset(bytes_view data) {
-    _buffer = seastar::temporary_buffer<uint8_t>(data.size());
-    std::memcpy(_buffer.get_write(), data.data(), data.size());
+    _data = data;
+    _buffer = {};
+    _copied = false;
 }
 
 template <format::Type::type ParquetType>
@@ -430,47 +730,141 @@ size_t plain_decoder_trivial<ParquetType>::read_batch(size_t n, output_type out[
 
 size_t plain_decoder_boolean::read_batch(size_t n, uint8_t out[]) { return _decoder.GetBatch(1, out, n); }
 
+// Read the next value. Return false at the end of data.
+bool plain_decoder_byte_array::next(bytes_view& value) {
+    if (_data.size() == 0) {
+        return false;
+    }
+    if (_data.size() < 4) {
+        throw parquet_exception::corrupted_file(
+          seastar::format("End of page while reading BYTE_ARRAY length (needed {}B, got {}B)", 4, _data.size()));
+    }
+    uint32_t len;
+    std::memcpy(&len, _data.data(), 4);
+    _data.remove_prefix(4);
+    if (len > _data.size()) {
+        throw parquet_exception::corrupted_file(
+          seastar::format("End of page while reading BYTE_ARRAY (needed {}B, got {}B)", len, _data.size()));
+    }
+    value = _data.substr(0, len);
+    _data.remove_prefix(len);
+    return true;
+}
+
 size_t plain_decoder_byte_array::read_batch(size_t n, seastar::temporary_buffer<uint8_t> out[]) {
+    if (!_copied) {
+        _buffer = seastar::temporary_buffer<uint8_t>(_data.data(), _data.size());
+        _data = bytes_view{_buffer.get(), _buffer.size()};
+        _copied = true;
+    }
+    bytes_view value;
     for (size_t i = 0; i < n; ++i) {
-        if (_buffer.size() == 0) {
+        if (!next(value)) {
             return i;
         }
-        if (_buffer.size() < 4) {
-            throw parquet_exception::corrupted_file(
-              seastar::format("End of page while reading BYTE_ARRAY length (needed {}B, got {}B)", 4, _buffer.size()));
-        }
-        uint32_t len;
-        std::memcpy(&len, _buffer.get(), 4);
-        _buffer.trim_front(4);
-        if (len > _buffer.size()) {
-            throw parquet_exception::corrupted_file(
-              seastar::format("End of page while reading BYTE_ARRAY (needed {}B, got {}B)", len, _buffer.size()));
-        }
-        out[i] = _buffer.share(0, len);
-        _buffer.trim_front(len);
+        out[i] = _buffer.share(value.data() - _buffer.get(), value.size());
     }
     return n;
 }
 
+template <typename OffsetT>
+size_t plain_decoder_byte_array::read_contiguous_impl(size_t n, byte_array_arena<OffsetT>& out) {
+    // The first pass only reads and checks the lengths, so that the second pass can copy the values
+    // into a buffer of the right size.
+    const uint8_t* begin = _data.data();
+    size_t total_len = 0;
+    size_t n_read = 0;
+    bytes_view value;
+    while (n_read < n && next(value)) {
+        total_len += value.size();
+        ++n_read;
+    }
+    out.reserve_data(total_len);
+    for (size_t i = 0; i < n_read; ++i) {
+        uint32_t len;
+        std::memcpy(&len, begin, 4);
+        out.push_back(bytes_view{begin + 4, len});
+        begin += 4 + len;
+    }
+    return n_read;
+}
+
 size_t plain_decoder_fixed_len_byte_array::read_batch(size_t n, seastar::temporary_buffer<uint8_t> out[]) {
+    if (!_copied) {
+        _buffer = seastar::temporary_buffer<uint8_t>(_data.data(), _data.size());
+        _data = bytes_view{_buffer.get(), _buffer.size()};
+        _copied = true;
+    }
     for (size_t i = 0; i < n; ++i) {
-        if (_buffer.size() == 0) {
+        if (_data.size() == 0) {
             return i;
         }
-        if (_fixed_len > _buffer.size()) {
+        if (_fixed_len > _data.size()) {
             throw parquet_exception::corrupted_file(seastar::format(
-              "End of page while reading FIXED_LEN_BYTE_ARRAY (needed {}B, got {}B)", _fixed_len, _buffer.size()));
+              "End of page while reading FIXED_LEN_BYTE_ARRAY (needed {}B, got {}B)", _fixed_len, _data.size()));
         }
-        out[i] = _buffer.share(0, _fixed_len);
-        _buffer.trim_front(_fixed_len);
+        out[i] = _buffer.share(_data.data() - _buffer.get(), _fixed_len);
+        _data.remove_prefix(_fixed_len);
     }
     return n;
 }
 
+size_t plain_decoder_fixed_len_byte_array::read_fixed(size_t n, uint8_t out[]) {
+    if (_fixed_len == 0) {
+        return _data.size() == 0 ? 0 : n;
+    }
+    // Plain values are already back to back.
+    size_t n_to_read = std::min(_data.size() / _fixed_len, n);
+    if (n_to_read < n && _data.size() % _fixed_len != 0) {
+        throw parquet_exception::corrupted_file(
+          seastar::format("End of page while reading FIXED_LEN_BYTE_ARRAY (needed {}B, got {}B)", _fixed_len,
+                          _data.size() % _fixed_len));
+    }
+    if (n_to_read > 0) {
+        std::memcpy(out, _data.data(), n_to_read * _fixed_len);
+    }
+    _data.remove_prefix(n_to_read * _fixed_len);
+    return n_to_read;
+}
+
+template <format::Type::type ParquetType>
+size_t plain_decoder_trivial<ParquetType>::skip(size_t n) {
+    size_t n_to_skip = std::min(_buffer.size() / sizeof(output_type), n);
+    _buffer.remove_prefix(sizeof(output_type) * n_to_skip);
+    return n_to_skip;
+}
+
+size_t plain_decoder_boolean::skip(size_t n) { return _decoder.Skip(1, n); }
+
+size_t plain_decoder_byte_array::skip(size_t n) {
+    // Only the lengths are read.
+    bytes_view value;
+    for (size_t i = 0; i < n; ++i) {
+        if (!next(value)) {
+            return i;
+        }
+    }
+    return n;
+}
+
+size_t plain_decoder_fixed_len_byte_array::skip(size_t n) {
+    if (_fixed_len == 0) {
+        return _data.size() == 0 ? 0 : n;
+    }
+    size_t n_to_skip = std::min(_data.size() / _fixed_len, n);
+    _data.remove_prefix(n_to_skip * _fixed_len);
+    if (n_to_skip < n && _data.size() > 0) {
+        throw parquet_exception::corrupted_file(seastar::format(
+          "End of page while reading FIXED_LEN_BYTE_ARRAY (needed {}B, got {}B)", _fixed_len, _data.size()));
+    }
+    return n_to_skip;
+}
+
 template <format::Type::type ParquetType>
 void dict_decoder<ParquetType>::reset(bytes_view data) {
     if (data.size() == 0) {
         _rle_decoder.Reset(data.data(), data.size(), 0);
+        return;
     }
     int bit_width = data.data()[0];
     if (bit_width < 0 || bit_width > 32) {
@@ -482,54 +876,274 @@ void dict_decoder<ParquetType>::reset(bytes_view data) {
 
 template <format::Type::type ParquetType>
 size_t dict_decoder<ParquetType>::read_batch(size_t n, output_type out[]) {
-    uint32_t buf[256];
-    size_t completed = 0;
-    while (completed < n) {
-        size_t n_to_read = std::min(n - completed, std::size(buf));
-        size_t n_read = _rle_decoder.GetBatch(std::data(buf), n_to_read);
-        for (size_t i = 0; i < n_read; ++i) {
-            if (buf[i] > _dict_size) {
-                throw parquet_exception::corrupted_file(
-                  seastar::format("Dict index exceeds dict size (dict size = {}, index = {})", _dict_size, buf[i]));
+    if constexpr (by_value) {
+        uint64_t max_index = 0;
+        int32_t dict_length = static_cast<int32_t>(std::min<size_t>(_dict_size, std::numeric_limits<int32_t>::max()));
+        size_t n_read = _rle_decoder.GetBatchWithDict(_dict, dict_length, out, n, &max_index);
+        check_index(max_index);
+        return n_read;
+    } else {
+        // Each output owns a reference to its dictionary entry, since it may outlive the dictionary.
+        // That costs a refcount update per value. Readers which don't need owning values should use
+        // read_contiguous, which copies from _views instead.
+        uint32_t buf[256];
+        size_t completed = 0;
+        while (completed < n) {
+            size_t n_read = read_indices(std::min(n - completed, std::size(buf)), buf);
+            for (size_t i = 0; i < n_read; ++i) {
+                out[completed + i] = _dict[buf[i]].share();
             }
-            if constexpr (std::is_trivially_copyable_v<output_type>) {
-                out[completed] = _dict[buf[i]];
-            } else {
-                // Why isn't seastar::temporary_buffer copyable though?
-                out[completed] = _dict[buf[i]].share();
+            completed += n_read;
+            if (n_read == 0) {
+                break;
             }
-            ++completed;
         }
-        if (n_read < n_to_read) {
-            break;
+        return completed;
+    }
+}
+
+template <format::Type::type ParquetType>
+size_t dict_decoder<ParquetType>::skip(size_t n) {
+    // Skipped indices are not validated, since they are never used.
+    return _rle_decoder.Skip(n);
+}
+
+template <format::Type::type ParquetType>
+template <typename OffsetT>
+size_t dict_decoder<ParquetType>::read_contiguous_impl(size_t n, byte_array_arena<OffsetT>& out) {
+    if constexpr (std::is_same_v<output_type, seastar::temporary_buffer<uint8_t>>) {
+        // Copied straight from the dictionary, without sharing a temporary_buffer per value.
+        uint32_t buf[256];
+        size_t completed = 0;
+        while (completed < n) {
+            size_t n_read = read_indices(std::min(n - completed, std::size(buf)), buf);
+            out.append_indexed(_views.data(), buf, n_read);
+            completed += n_read;
+            if (n_read == 0) {
+                break;
+            }
+        }
+        return completed;
+    } else {
+        return this->read_contiguous_by_value(n, out);
+    }
+}
+
+namespace {
+
+// Copy dictionary entries of Width bytes. A constant width lets the compiler inline the copies.
+template <size_t Width>
+void gather_fixed(const seastar::temporary_buffer<uint8_t> dict[], const uint32_t indices[], size_t n,
+                  uint8_t out[]) {
+    for (size_t i = 0; i < n; ++i) {
+        std::memcpy(out + i * Width, dict[indices[i]].get(), Width);
+    }
+}
+
+void gather_fixed(const seastar::temporary_buffer<uint8_t> dict[], const uint32_t indices[], size_t n, size_t width,
+                  uint8_t out[]) {
+    for (size_t i = 0; i < n; ++i) {
+        std::memcpy(out + i * width, dict[indices[i]].get(), width);
+    }
+}
+
+}  // namespace
+
+template <format::Type::type ParquetType>
+size_t dict_decoder<ParquetType>::read_fixed(size_t n, uint8_t out[]) {
+    if constexpr (ParquetType == format::Type::FIXED_LEN_BYTE_ARRAY) {
+        // All entries of a FIXED_LEN_BYTE_ARRAY dictionary have the same size.
+        size_t width = _dict_size > 0 ? _dict[0].size() : 0;
+        uint32_t buf[256];
+        size_t completed = 0;
+        while (completed < n) {
+            size_t n_read = read_indices(std::min(n - completed, std::size(buf)), buf);
+            uint8_t* chunk_out = out + completed * width;
+            switch (width) {
+                case 12:  // INTERVAL
+                    gather_fixed<12>(_dict, buf, n_read, chunk_out);
+                    break;
+                case 16:  // UUID, DECIMAL(38)
+                    gather_fixed<16>(_dict, buf, n_read, chunk_out);
+                    break;
+                default:
+                    gather_fixed(_dict, buf, n_read, width, chunk_out);
+            }
+            completed += n_read;
+            if (n_read == 0) {
+                break;
+            }
         }
+        return completed;
+    } else {
+        return decoder<ParquetType>::read_fixed(n, out);
     }
-    return completed;
+}
+
+template <format::Type::type ParquetType>
+size_t dict_decoder<ParquetType>::read_indices(size_t n, uint32_t out[]) {
+    size_t n_read = _rle_decoder.GetBatch(out, n);
+    // A branch-free max, rather than a check per index, lets the compiler vectorize the loop.
+    uint32_t max_index = 0;
+    for (size_t i = 0; i < n_read; ++i) {
+        max_index = std::max(max_index, out[i]);
+    }
+    if (n_read > 0) {
+        check_index(max_index);
+    }
+    return n_read;
 }
 
 void rle_decoder_boolean::reset(bytes_view data) { _rle_decoder.Reset(data.data(), data.size(), 1); }
 
 size_t rle_decoder_boolean::read_batch(size_t n, uint8_t out[]) { return _rle_decoder.GetBatch(out, n); }
 
+size_t rle_decoder_boolean::skip(size_t n) { return _rle_decoder.Skip(n); }
+
+namespace {
+
+// The decoders valid for each physical type. monostate stands for no data page yet.
+template <format::Type::type ParquetType>
+struct decoder_alternatives
+{
+    using type = std::variant<std::monostate, plain_decoder_trivial<ParquetType>, dict_decoder<ParquetType>>;
+};
+
+template <format::Type::type ParquetType>
+  requires(ParquetType == format::Type::INT32 || ParquetType == format::Type::INT64)
+struct decoder_alternatives<ParquetType>
+{
+    using type = std::variant<std::monostate, plain_decoder_trivial<ParquetType>, dict_decoder<ParquetType>,
+                              delta_binary_packed_decoder<ParquetType>>;
+};
+
+template <format::Type::type ParquetType>
+  requires(ParquetType == format::Type::FLOAT || ParquetType == format::Type::DOUBLE)
+struct decoder_alternatives<ParquetType>
+{
+    using type = std::variant<std::monostate, plain_decoder_trivial<ParquetType>, dict_decoder<ParquetType>,
+                              byte_stream_split_decoder<ParquetType>>;
+};
+
+template <>
+struct decoder_alternatives<format::Type::BOOLEAN>
+{
+    using type = std::variant<std::monostate, plain_decoder_boolean, dict_decoder<format::Type::BOOLEAN>,
+                              rle_decoder_boolean>;
+};
+
+template <>
+struct decoder_alternatives<format::Type::BYTE_ARRAY>
+{
+    using type = std::variant<std::monostate, plain_decoder_byte_array, dict_decoder<format::Type::BYTE_ARRAY>,
+                              delta_length_byte_array_decoder, delta_byte_array_decoder>;
+};
+
+template <>
+struct decoder_alternatives<format::Type::FIXED_LEN_BYTE_ARRAY>
+{
+    using type = std::variant<std::monostate, plain_decoder_fixed_len_byte_array,
+                              dict_decoder<format::Type::FIXED_LEN_BYTE_ARRAY>>;
+};
+
+// The PLAIN decoder of each physical type.
+template <format::Type::type ParquetType>
+struct plain_decoder_for
+{
+    using type = plain_decoder_trivial<ParquetType>;
+};
+
+template <>
+struct plain_decoder_for<format::Type::BOOLEAN>
+{
+    using type = plain_decoder_boolean;
+};
+
+template <>
+struct plain_decoder_for<format::Type::BYTE_ARRAY>
+{
+    using type = plain_decoder_byte_array;
+};
+
+template <>
+struct plain_decoder_for<format::Type::FIXED_LEN_BYTE_ARRAY>
+{
+    using type = plain_decoder_fixed_len_byte_array;
+};
+
+template <format::Type::type ParquetType>
+using plain_decoder_for_t = typename plain_decoder_for<ParquetType>::type;
+
+// Make D the active decoder. If it already is, it is kept as is, with its buffers.
+template <typename D, typename Variant, typename... Args>
+D& activate(Variant& decoders, Args&&... args) {
+    if (D* d = std::get_if<D>(&decoders)) {
+        return *d;
+    }
+    return decoders.template emplace<D>(std::forward<Args>(args)...);
+}
+
+// Call f with the active decoder, as its concrete (final) type.
+template <typename Variant, typename F>
+size_t with_active(Variant& decoders, F&& f) {
+    return std::visit(overloaded{
+                        [](std::monostate&) -> size_t { throw parquet_exception("No data page to decode"); },
+                        [&f](auto& d) -> size_t { return f(d); },
+                      },
+                      decoders);
+}
+
+}  // namespace
+
+template <format::Type::type ParquetType>
+struct value_decoder<ParquetType>::decoders
+{
+    typename decoder_alternatives<ParquetType>::type active;
+};
+
+template <format::Type::type ParquetType>
+value_decoder<ParquetType>::value_decoder(std::optional<uint32_t> type_length)
+    : _decoders{std::make_unique<decoders>()}, _type_length(type_length) {
+    if constexpr (ParquetType == format::Type::FIXED_LEN_BYTE_ARRAY) {
+        if (!_type_length) {
+            throw parquet_exception::corrupted_file("type_length not set for FIXED_LEN_BYTE_ARRAY");
+        }
+    }
+}
+
+template <format::Type::type ParquetType>
+value_decoder<ParquetType>::value_decoder(value_decoder&&) noexcept = default;
+
+template <format::Type::type ParquetType>
+value_decoder<ParquetType>& value_decoder<ParquetType>::operator=(value_decoder&&) noexcept = default;
+
+template <format::Type::type ParquetType>
+value_decoder<ParquetType>::~value_decoder() = default;
+
 template <format::Type::type ParquetType>
 void value_decoder<ParquetType>::reset_dict(output_type dictionary[], size_t dictionary_size) {
     _dict = dictionary;
     _dict_size = dictionary_size;
     _dict_set = true;
+    // A dictionary decoder kept from an earlier page switches to the new dictionary.
+    if (auto* d = std::get_if<dict_decoder<ParquetType>>(&_decoders->active)) {
+        d->reset_dict(dictionary, dictionary_size);
+    }
 };
 
 template <format::Type::type ParquetType>
 void value_decoder<ParquetType>::reset(bytes_view buf, format::Encoding::type encoding) {
+    auto& active = _decoders->active;
     switch (encoding) {
         case format::Encoding::PLAIN:
             if constexpr (ParquetType == format::Type::BOOLEAN) {
-                _decoder = std::make_unique<plain_decoder_boolean>();
+                activate<plain_decoder_boolean>(active);
             } else if constexpr (ParquetType == format::Type::BYTE_ARRAY) {
-                _decoder = std::make_unique<plain_decoder_byte_array>();
+                activate<plain_decoder_byte_array>(active);
             } else if constexpr (ParquetType == format::Type::FIXED_LEN_BYTE_ARRAY) {
-                _decoder = std::make_unique<plain_decoder_fixed_len_byte_array>(static_cast<size_t>(*_type_length));
+                activate<plain_decoder_fixed_len_byte_array>(active, static_cast<size_t>(*_type_length));
             } else {
-                _decoder = std::make_unique<plain_decoder_trivial<ParquetType>>();
+                activate<plain_decoder_trivial<ParquetType>>(active);
             }
             break;
         case format::Encoding::RLE_DICTIONARY:
@@ -537,39 +1151,39 @@ void value_decoder<ParquetType>::reset(bytes_view buf, format::Encoding::type en
             if (!_dict_set) {
                 throw parquet_exception::corrupted_file("No dictionary page found before a dictionary-encoded page");
             }
-            _decoder = std::make_unique<dict_decoder<ParquetType>>(_dict, _dict_size);
+            activate<dict_decoder<ParquetType>>(active, _dict, _dict_size);
             break;
         case format::Encoding::RLE:
             if constexpr (ParquetType == format::Type::BOOLEAN) {
-                _decoder = std::make_unique<rle_decoder_boolean>();
+                activate<rle_decoder_boolean>(active);
             } else {
                 throw parquet_exception::corrupted_file("RLE encoding is valid only for BOOLEAN values");
             }
             break;
         case format::Encoding::DELTA_BINARY_PACKED:
             if constexpr (ParquetType == format::Type::INT32 || ParquetType == format::Type::INT64) {
-                _decoder = std::make_unique<delta_binary_packed_decoder<ParquetType>>();
+                activate<delta_binary_packed_decoder<ParquetType>>(active);
             } else {
                 throw parquet_exception::corrupted_file("DELTA_BINARY_PACKED is valid only for INT32 and INT64");
             }
             break;
         case format::Encoding::DELTA_LENGTH_BYTE_ARRAY:
             if constexpr (ParquetType == format::Type::BYTE_ARRAY) {
-                _decoder = std::make_unique<delta_length_byte_array_decoder>();
+                activate<delta_length_byte_array_decoder>(active);
             } else {
                 throw parquet_exception::corrupted_file("DELTA_LENGTH_BYTE_ARRAY is valid only for BYTE_ARRAY");
             }
             break;
         case format::Encoding::DELTA_BYTE_ARRAY:
             if constexpr (ParquetType == format::Type::BYTE_ARRAY) {
-                _decoder = std::make_unique<delta_byte_array_decoder>();
+                activate<delta_byte_array_decoder>(active);
             } else {
                 throw parquet_exception::corrupted_file("DELTA_BYTE_ARRAY is valid only for BYTE_ARRAY");
             }
             break;
         case format::Encoding::BYTE_STREAM_SPLIT:
             if constexpr (ParquetType == format::Type::FLOAT || ParquetType == format::Type::DOUBLE) {
-                _decoder = std::make_unique<byte_stream_split_decoder<ParquetType>>();
+                activate<byte_stream_split_decoder<ParquetType>>(active);
             } else {
                 throw parquet_exception::corrupted_file("BYTE_STREAM_SPLIT is valid only for FLOAT and DOUBLE");
             }
@@ -577,12 +1191,60 @@ void value_decoder<ParquetType>::reset(bytes_view buf, format::Encoding::type en
         default:
             throw parquet_exception(seastar::format("Encoding {} not implemented", static_cast<int32_t>(encoding)));
     }
-    _decoder->reset(buf);
+    with_active(active, [buf](auto& d) {
+        d.reset(buf);
+        return size_t(0);
+    });
+    _dictionary_encoded =
+      encoding == format::Encoding::RLE_DICTIONARY || encoding == format::Encoding::PLAIN_DICTIONARY;
+    _plain_encoded = encoding == format::Encoding::PLAIN;
 };
 
 template <format::Type::type ParquetType>
 size_t value_decoder<ParquetType>::read_batch(size_t n, output_type out[]) {
-    return _decoder->read_batch(n, out);
+    return with_active(_decoders->active, [n, out](auto& d) { return d.read_batch(n, out); });
+};
+
+template <format::Type::type ParquetType>
+size_t value_decoder<ParquetType>::read_plain(size_t n, output_type out[]) {
+    assert(_plain_encoded);
+    return std::get<plain_decoder_for_t<ParquetType>>(_decoders->active).read_batch(n, out);
+};
+
+template <format::Type::type ParquetType>
+size_t value_decoder<ParquetType>::read_dictionary(size_t n, output_type out[]) {
+    assert(_dictionary_encoded);
+    return std::get<dict_decoder<ParquetType>>(_decoders->active).read_batch(n, out);
+};
+
+template <format::Type::type ParquetType>
+size_t value_decoder<ParquetType>::read_batch(size_t n, byte_array_arena<int32_t>& out) {
+    return with_active(_decoders->active, [n, &out](auto& d) { return d.read_contiguous(n, out); });
+};
+
+template <format::Type::type ParquetType>
+size_t value_decoder<ParquetType>::read_batch(size_t n, byte_array_arena<int64_t>& out) {
+    return with_active(_decoders->active, [n, &out](auto& d) { return d.read_contiguous(n, out); });
+};
+
+template <format::Type::type ParquetType>
+size_t value_decoder<ParquetType>::read_batch(size_t n, fixed_len_buffer& out) {
+    size_t n_read = with_active(_decoders->active, [this, n, &out](auto& d) {
+        return d.read_fixed(n, out.data + out.size * *_type_length);
+    });
+    out.size += n_read;
+    return n_read;
+};
+
+template <format::Type::type ParquetType>
+size_t value_decoder<ParquetType>::skip(size_t n) {
+    return with_active(_decoders->active, [n](auto& d) { return d.skip(n); });
+};
+
+template <format::Type::type ParquetType>
+size_t value_decoder<ParquetType>::read_indices(size_t n, uint32_t out[]) {
+    assert(_dictionary_encoded);
+    return std::get<dict_decoder<ParquetType>>(_decoders->active).read_indices(n, out);
 };
 
 /*
@@ -610,6 +1272,48 @@ template class value_decoder<format::Type::BOOLEAN>;
 template class value_decoder<format::Type::BYTE_ARRAY>;
 template class value_decoder<format::Type::FIXED_LEN_BYTE_ARRAY>;
 
+namespace {
+
+// Place the width bytes at the top of a 128-bit word and shift them down arithmetically, which extends the sign.
+// There are no branches, so that loops over values can be vectorized.
+inline __int128 load_decimal(const uint8_t in[], size_t width) {
+    uint8_t be[16] = {};
+    std::memcpy(be, in, width);
+    uint64_t hi;
+    uint64_t lo;
+    std::memcpy(&hi, be, 8);
+    std::memcpy(&lo, be + 8, 8);
+    unsigned __int128 u = (static_cast<unsigned __int128>(__builtin_bswap64(hi)) << 64) | __builtin_bswap64(lo);
+    return static_cast<__int128>(u) >> (8 * (16 - width));
+}
+
+template <size_t Width>
+void decode_decimals_fixed(const uint8_t in[], size_t n, __int128 out[]) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = load_decimal(in + i * Width, Width);
+    }
+}
+
+}  // namespace
+
+void decode_decimals(const uint8_t in[], size_t width, size_t n, __int128 out[]) {
+    switch (width) {
+        case 16:
+            decode_decimals_fixed<16>(in, n, out);
+            break;
+        case 12:
+            decode_decimals_fixed<12>(in, n, out);
+            break;
+        default:
+            if (width == 0 || width > 16) {
+                throw parquet_exception(seastar::format("DECIMAL width {}B is out of range (1B to 16B)", width));
+            }
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = load_decimal(in + i * width, width);
+            }
+    }
+}
+
 template <format::Type::type ParquetType>
 class plain_encoder : public value_encoder<ParquetType>
 {
@@ -780,6 +1484,9 @@ class dict_encoder : public value_encoder<ParquetType>
         _indices.reserve(_indices.size() + size);
         for (size_t i = 0; i < size; ++i) {
             _indices.push_back(_values.put(data[i]));
+            if ((i + 1) % this->PREEMPTION_CHECK_INTERVAL == 0) {
+                this->maybe_yield();
+            }
         }
     }
     size_t max_encoded_size() const override {
@@ -789,8 +1496,11 @@ class dict_encoder : public value_encoder<ParquetType>
     flush_result flush(byte sink[]) override {
         *sink = static_cast<byte>(index_bit_width());
         RleEncoder encoder{sink + 1, static_cast<int>(max_encoded_size() - 1), index_bit_width()};
-        for (uint32_t index : _indices) {
-            encoder.Put(index);
+        for (size_t i = 0; i < _indices.size(); ++i) {
+            encoder.Put(_indices[i]);
+            if ((i + 1) % this->PREEMPTION_CHECK_INTERVAL == 0) {
+                this->maybe_yield();
+            }
         }
         encoder.Flush();
         _indices.clear();
@@ -842,6 +1552,10 @@ class dict_or_plain_encoder : public value_encoder<ParquetType>
     }
     std::optional<bytes_view> view_dict() override { return _dict_encoder.view_dict(); }
     uint64_t cardinality() override { return _dict_encoder.cardinality(); }
+    void set_yield_hook(yield_hook hook) override {
+        _dict_encoder.set_yield_hook(hook);
+        _plain_encoder.set_yield_hook(std::move(hook));
+    }
 };
 
 template <format::Type::type ParquetType>
@@ -962,6 +1676,9 @@ class delta_binary_packed_encoder : public value_encoder<ParquetType>
             if (_unencoded_values.size() == BLOCK_VALUES) {
                 flush_block();
             }
+            if ((i + 1) % this->PREEMPTION_CHECK_INTERVAL == 0) {
+                this->maybe_yield();
+            }
         }
 
         _total_values += size;
@@ -113,9 +113,11 @@ seastar::future<column_chunk_reader<T>> file_reader::open_column_chunk_reader_in
     size_t file_offset = column_metadata->__isset.dictionary_page_offset ? column_metadata->dictionary_page_offset
                                                                          : column_metadata->data_page_offset;
     auto peek_stream = file().make_peekable_stream(file_offset, column_metadata->total_compressed_size, {8192, 16});
+    peek_stream->set_memory_limiter(_memory_limiter);
     co_return column_chunk_reader<T>{
       page_reader{std::move(peek_stream)}, column_metadata->codec, leaf.def_level, leaf.rep_level,
-      (leaf.info.__isset.type_length ? std::optional<uint32_t>(leaf.info.type_length) : std::optional<uint32_t>{})};
+      (leaf.info.__isset.type_length ? std::optional<uint32_t>(leaf.info.type_length) : std::optional<uint32_t>{}),
+      _offload, _memory_limiter};
 }
 
 template <format::Type::type T>
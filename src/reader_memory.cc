@@ -0,0 +1,65 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/reader_memory.hh>
+#include <seastar/core/metrics.hh>
+
+namespace parquet4seastar {
+
+reader_memory_limiter::reader_memory_limiter(size_t limit) : _limit{limit}, _units{limit} {
+    namespace sm = seastar::metrics;
+    _metrics.add_group("parquet4seastar",
+                       {
+                         sm::make_gauge(
+                           "reader_memory_used_bytes", [this] { return used(); },
+                           sm::description("Memory held by readers' stream, decompression and dictionary buffers")),
+                         sm::make_gauge(
+                           "reader_memory_waiters", [this] { return waiters(); },
+                           sm::description("Readers waiting for the memory limit to free up")),
+                       });
+}
+
+seastar::future<reader_memory_units> reader_memory_limiter::reserve(size_t bytes) {
+    return seastar::get_units(_units, std::min(bytes, _limit));
+}
+
+seastar::future<> reader_memory_charge::resize(size_t size) {
+    if (!_limiter) {
+        return seastar::make_ready_future<>();
+    }
+    size = std::min(size, _limiter->limit());
+    size_t charged = _units.count();
+    if (size == charged) {
+        return seastar::make_ready_future<>();
+    } else if (size < charged) {
+        _units.return_units(charged - size);
+        return seastar::make_ready_future<>();
+    }
+    return _limiter->reserve(size - charged).then([this](reader_memory_units units) {
+        if (_units.count() == 0) {
+            _units = std::move(units);
+        } else {
+            _units.adopt(std::move(units));
+        }
+    });
+}
+
+}  // namespace parquet4seastar
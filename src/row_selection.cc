@@ -0,0 +1,75 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+
+#include <parquet4seastar/exception.hh>
+#include <parquet4seastar/row_selection.hh>
+
+namespace parquet4seastar {
+
+row_selection row_selection::from_bitmap(const uint8_t* bits, uint64_t n_rows) {
+    row_selection selection;
+    uint64_t i = 0;
+    while (i < n_rows) {
+        // Skip unset bits a byte at a time where possible.
+        if (i % 8 == 0 && i + 8 <= n_rows && bits[i / 8] == 0) {
+            i += 8;
+            continue;
+        }
+        if (!(bits[i / 8] & (1 << (i % 8)))) {
+            ++i;
+            continue;
+        }
+        uint64_t begin = i;
+        while (i < n_rows && (bits[i / 8] & (1 << (i % 8)))) {
+            ++i;
+        }
+        selection.add(begin, i);
+    }
+    return selection;
+}
+
+row_selection row_selection::all(uint64_t n_rows) {
+    row_selection selection;
+    selection.add(0, n_rows);
+    return selection;
+}
+
+void row_selection::add(uint64_t begin, uint64_t end) {
+    if (begin > end) {
+        throw parquet_exception(seastar::format("Invalid row range [{}, {})", begin, end));
+    }
+    if (begin == end) {
+        return;
+    }
+    if (!_ranges.empty() && begin < _ranges.back().end) {
+        throw parquet_exception(seastar::format("Row range [{}, {}) overlaps or precedes the selected range [{}, {})",
+                                                begin, end, _ranges.back().begin, _ranges.back().end));
+    }
+    if (!_ranges.empty() && begin == _ranges.back().end) {
+        _ranges.back().end = end;
+    } else {
+        _ranges.push_back(row_range{begin, end});
+    }
+    _row_count += end - begin;
+}
+
+}  // namespace parquet4seastar
@@ -19,6 +19,8 @@
  * Copyright (C) 2020 ScyllaDB
  */
 
+#include <parquet4seastar/parquet_types.h>
+#include <limits>
 #include <parquet4seastar/thrift_serdes.hh>
 
 namespace parquet4seastar {
@@ -55,23 +57,27 @@ seastar::future<> peekable_stream::read_exactly(size_t n) {
  * Our strategy (rewind only when _buffer_start moves past half of buffer.size()) guarantees that
  * we will actively use at least 1/2 of allocated memory, and that any given byte is rewound at most once.
  */
-void peekable_stream::ensure_space(size_t n) {
+seastar::future<> peekable_stream::ensure_space(size_t n) {
     if (_buffer.size() - _buffer_end >= n) {
-        return;
+        return seastar::make_ready_future<>();
     } else if (_buffer.size() > n + (_buffer_end - _buffer_start) && _buffer_start > _buffer.size() / 2) {
         // Rewind the buffer.
         std::memmove(_buffer.data(), _buffer.data() + _buffer_start, _buffer_end - _buffer_start);
         _buffer_end -= _buffer_start;
         _buffer_start = 0;
+        return seastar::make_ready_future<>();
     } else {
         // Allocate a bigger buffer and move unconsumed data into it.
-        buffer b{_buffer_end + n};
-        if (_buffer_end - _buffer_start > 0) {
-            std::memcpy(b.data(), _buffer.data() + _buffer_start, _buffer_end - _buffer_start);
-        }
-        _buffer = std::move(b);
-        _buffer_end -= _buffer_start;
-        _buffer_start = 0;
+        // The memory is charged to the reader memory budget beforehand.
+        return _buffer_charge.resize(buffer::next_power_of_2(_buffer_end + n)).then([this, n] {
+            buffer b{_buffer_end + n};
+            if (_buffer_end - _buffer_start > 0) {
+                std::memcpy(b.data(), _buffer.data() + _buffer_start, _buffer_end - _buffer_start);
+            }
+            _buffer = std::move(b);
+            _buffer_end -= _buffer_start;
+            _buffer_start = 0;
+        });
     }
 }
 
@@ -83,10 +89,9 @@ seastar::future<bytes_view> peekable_stream::peek(size_t n) {
         return seastar::make_ready_future<bytes_view>(bytes_view{_buffer.data() + _buffer_start, n});
     } else {
         size_t bytes_needed = n - (_buffer_end - _buffer_start);
-        ensure_space(bytes_needed);
-        return read_exactly(bytes_needed).then([this] {
-            return bytes_view(_buffer.data() + _buffer_start, _buffer_end - _buffer_start);
-        });
+        return ensure_space(bytes_needed)
+          .then([this, bytes_needed] { return read_exactly(bytes_needed); })
+          .then([this] { return bytes_view(_buffer.data() + _buffer_start, _buffer_end - _buffer_start); });
     }
 }
 
@@ -104,4 +109,645 @@ seastar::future<> peekable_stream::advance(size_t n) {
     }
 }
 
+namespace {
+
+/* A reader of the thrift compact protocol.
+ * Reading past the end of data yields zeros (and so STOP fields) instead of failing, and marks the reader
+ * truncated. That way the parse unwinds without checking every read, and the reader remembers how many bytes
+ * the header needs at least.
+ */
+class compact_reader
+{
+    const uint8_t* _begin;
+    const uint8_t* _pos;
+    const uint8_t* _end;
+    bool _truncated = false;
+    size_t _min_size = 0;
+    int _depth = 0;
+    static constexpr int max_depth = 64;
+
+    // needed may be a length read from the data, so the sum saturates instead of overflowing.
+    void truncate(uint64_t needed) {
+        size_t consumed = _pos - _begin;
+        size_t limit = std::numeric_limits<size_t>::max() - consumed;
+        _min_size = std::max(_min_size, needed > limit ? std::numeric_limits<size_t>::max() : consumed + needed);
+        _truncated = true;
+        _pos = _end;
+    }
+
+   public:
+    enum type : uint8_t
+    {
+        STOP = 0,
+        BOOLEAN_TRUE = 1,
+        BOOLEAN_FALSE = 2,
+        BYTE = 3,
+        I16 = 4,
+        I32 = 5,
+        I64 = 6,
+        DOUBLE = 7,
+        BINARY = 8,
+        LIST = 9,
+        SET = 10,
+        MAP = 11,
+        STRUCT = 12,
+    };
+    struct field
+    {
+        type t;
+        int16_t id;
+    };
+
+    explicit compact_reader(bytes_view data)
+        : _begin{data.data()}, _pos{data.data()}, _end{data.data() + data.size()} {}
+    bool truncated() const { return _truncated; }
+    size_t consumed() const { return _pos - _begin; }
+    size_t min_size() const { return _min_size; }
+
+    uint8_t read_byte() {
+        if (_pos == _end) {
+            truncate(1);
+            return 0;
+        }
+        return *_pos++;
+    }
+    uint64_t read_varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = read_byte();
+            value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+        throw parquet_exception::corrupted_file("Varint too long in page header");
+    }
+    int64_t read_i64() {
+        uint64_t zigzag = read_varint();
+        return static_cast<int64_t>((zigzag >> 1) ^ -(zigzag & 1));
+    }
+    int32_t read_i32() { return static_cast<int32_t>(read_i64()); }
+    bytes_view read_binary() {
+        uint64_t len = read_varint();
+        if (len > static_cast<size_t>(_end - _pos)) {
+            truncate(len);
+            return {};
+        }
+        bytes_view value{_pos, len};
+        _pos += len;
+        return value;
+    }
+    void read_binary(std::string& out) {
+        bytes_view value = read_binary();
+        out.assign(reinterpret_cast<const char*>(value.data()), value.size());
+    }
+    // Read the header of the next field of a struct. last_id is the id of the previous field, or 0.
+    // The value of a boolean field is its type.
+    field read_field(int16_t& last_id) {
+        uint8_t header = read_byte();
+        type t = static_cast<type>(header & 0x0f);
+        if (t == STOP) {
+            return {STOP, 0};
+        }
+        int16_t delta = header >> 4;
+        last_id = delta ? last_id + delta : static_cast<int16_t>(read_i64());
+        return {t, last_id};
+    }
+    void enter_struct() {
+        if (++_depth > max_depth) {
+            throw parquet_exception::corrupted_file("Page header nested too deeply");
+        }
+    }
+    void leave_struct() { --_depth; }
+    void skip(type t);
+    void skip_element(type t) {
+        if (t == BOOLEAN_TRUE || t == BOOLEAN_FALSE) {
+            // Unlike boolean fields, boolean elements of containers take a byte each.
+            read_byte();
+        } else {
+            skip(t);
+        }
+    }
+};
+
+void compact_reader::skip(type t) {
+    switch (t) {
+        case BOOLEAN_TRUE:
+        case BOOLEAN_FALSE:
+            return;
+        case BYTE:
+            read_byte();
+            return;
+        case I16:
+        case I32:
+        case I64:
+            read_varint();
+            return;
+        case DOUBLE:
+            if (_end - _pos < 8) {
+                truncate(8);
+            } else {
+                _pos += 8;
+            }
+            return;
+        case BINARY:
+            read_binary();
+            return;
+        case LIST:
+        case SET: {
+            uint8_t header = read_byte();
+            uint64_t size = header >> 4;
+            if (size == 15) {
+                size = read_varint();
+            }
+            type element = static_cast<type>(header & 0x0f);
+            for (uint64_t i = 0; i < size && !_truncated; ++i) {
+                skip_element(element);
+            }
+            return;
+        }
+        case MAP: {
+            uint64_t size = read_varint();
+            if (size == 0) {
+                return;
+            }
+            uint8_t types = read_byte();
+            type key = static_cast<type>(types >> 4);
+            type value = static_cast<type>(types & 0x0f);
+            for (uint64_t i = 0; i < size && !_truncated; ++i) {
+                skip_element(key);
+                skip_element(value);
+            }
+            return;
+        }
+        case STRUCT: {
+            enter_struct();
+            int16_t last_id = 0;
+            for (field f = read_field(last_id); f.t != STOP; f = read_field(last_id)) {
+                skip(f.t);
+            }
+            leave_struct();
+            return;
+        }
+        default:
+            throw parquet_exception::corrupted_file(
+              seastar::format("Unknown thrift type {} in page header", static_cast<int>(t)));
+    }
+}
+
+void check_required(const compact_reader& r, bool is_set, const char* name) {
+    // Fields are missing from a truncated header because they have not been read yet.
+    if (!is_set && !r.truncated()) {
+        throw parquet_exception::corrupted_file(seastar::format("Required field {} missing in page header", name));
+    }
+}
+
+/* Headers are reset to their default values before parsing, as if newly constructed,
+ * except that the memory of their strings is kept.
+ */
+void reset(format::Statistics& s) {
+    s.max.clear();
+    s.min.clear();
+    s.null_count = 0;
+    s.distinct_count = 0;
+    s.max_value.clear();
+    s.min_value.clear();
+    s.__isset = {};
+}
+
+void reset(format::DataPageHeader& h) {
+    h.num_values = 0;
+    h.encoding = format::Encoding::type(0);
+    h.definition_level_encoding = format::Encoding::type(0);
+    h.repetition_level_encoding = format::Encoding::type(0);
+    reset(h.statistics);
+    h.__isset = {};
+}
+
+void reset(format::DictionaryPageHeader& h) {
+    h.num_values = 0;
+    h.encoding = format::Encoding::type(0);
+    h.is_sorted = false;
+    h.__isset = {};
+}
+
+void reset(format::DataPageHeaderV2& h) {
+    h.num_values = 0;
+    h.num_nulls = 0;
+    h.num_rows = 0;
+    h.encoding = format::Encoding::type(0);
+    h.definition_levels_byte_length = 0;
+    h.repetition_levels_byte_length = 0;
+    h.is_compressed = true;
+    reset(h.statistics);
+    h.__isset = {};
+}
+
+void reset(format::PageHeader& h) {
+    h.type = format::PageType::type(0);
+    h.uncompressed_page_size = 0;
+    h.compressed_page_size = 0;
+    h.crc = 0;
+    reset(h.data_page_header);
+    reset(h.dictionary_page_header);
+    reset(h.data_page_header_v2);
+    h.__isset = {};
+}
+
+// A field of an unexpected type is skipped, as in the code generated by Thrift.
+
+void read_statistics(compact_reader& r, format::Statistics& s) {
+    r.enter_struct();
+    int16_t last_id = 0;
+    for (auto f = r.read_field(last_id); f.t != compact_reader::STOP; f = r.read_field(last_id)) {
+        if (f.id == 1 && f.t == compact_reader::BINARY) {
+            r.read_binary(s.max);
+            s.__isset.max = true;
+        } else if (f.id == 2 && f.t == compact_reader::BINARY) {
+            r.read_binary(s.min);
+            s.__isset.min = true;
+        } else if (f.id == 3 && f.t == compact_reader::I64) {
+            s.null_count = r.read_i64();
+            s.__isset.null_count = true;
+        } else if (f.id == 4 && f.t == compact_reader::I64) {
+            s.distinct_count = r.read_i64();
+            s.__isset.distinct_count = true;
+        } else if (f.id == 5 && f.t == compact_reader::BINARY) {
+            r.read_binary(s.max_value);
+            s.__isset.max_value = true;
+        } else if (f.id == 6 && f.t == compact_reader::BINARY) {
+            r.read_binary(s.min_value);
+            s.__isset.min_value = true;
+        } else {
+            r.skip(f.t);
+        }
+    }
+    r.leave_struct();
+}
+
+void read_data_page_header(compact_reader& r, format::DataPageHeader& h) {
+    bool num_values = false;
+    bool encoding = false;
+    bool definition_level_encoding = false;
+    bool repetition_level_encoding = false;
+    r.enter_struct();
+    int16_t last_id = 0;
+    for (auto f = r.read_field(last_id); f.t != compact_reader::STOP; f = r.read_field(last_id)) {
+        if (f.id == 1 && f.t == compact_reader::I32) {
+            h.num_values = r.read_i32();
+            num_values = true;
+        } else if (f.id == 2 && f.t == compact_reader::I32) {
+            h.encoding = static_cast<format::Encoding::type>(r.read_i32());
+            encoding = true;
+        } else if (f.id == 3 && f.t == compact_reader::I32) {
+            h.definition_level_encoding = static_cast<format::Encoding::type>(r.read_i32());
+            definition_level_encoding = true;
+        } else if (f.id == 4 && f.t == compact_reader::I32) {
+            h.repetition_level_encoding = static_cast<format::Encoding::type>(r.read_i32());
+            repetition_level_encoding = true;
+        } else if (f.id == 5 && f.t == compact_reader::STRUCT) {
+            read_statistics(r, h.statistics);
+            h.__isset.statistics = true;
+        } else {
+            r.skip(f.t);
+        }
+    }
+    r.leave_struct();
+    check_required(r, num_values, "DataPageHeader.num_values");
+    check_required(r, encoding, "DataPageHeader.encoding");
+    check_required(r, definition_level_encoding, "DataPageHeader.definition_level_encoding");
+    check_required(r, repetition_level_encoding, "DataPageHeader.repetition_level_encoding");
+}
+
+void read_dictionary_page_header(compact_reader& r, format::DictionaryPageHeader& h) {
+    bool num_values = false;
+    bool encoding = false;
+    r.enter_struct();
+    int16_t last_id = 0;
+    for (auto f = r.read_field(last_id); f.t != compact_reader::STOP; f = r.read_field(last_id)) {
+        if (f.id == 1 && f.t == compact_reader::I32) {
+            h.num_values = r.read_i32();
+            num_values = true;
+        } else if (f.id == 2 && f.t == compact_reader::I32) {
+            h.encoding = static_cast<format::Encoding::type>(r.read_i32());
+            encoding = true;
+        } else if (f.id == 3 && (f.t == compact_reader::BOOLEAN_TRUE || f.t == compact_reader::BOOLEAN_FALSE)) {
+            h.is_sorted = f.t == compact_reader::BOOLEAN_TRUE;
+            h.__isset.is_sorted = true;
+        } else {
+            r.skip(f.t);
+        }
+    }
+    r.leave_struct();
+    check_required(r, num_values, "DictionaryPageHeader.num_values");
+    check_required(r, encoding, "DictionaryPageHeader.encoding");
+}
+
+void read_data_page_header_v2(compact_reader& r, format::DataPageHeaderV2& h) {
+    bool num_values = false;
+    bool num_nulls = false;
+    bool num_rows = false;
+    bool encoding = false;
+    bool definition_levels_byte_length = false;
+    bool repetition_levels_byte_length = false;
+    r.enter_struct();
+    int16_t last_id = 0;
+    for (auto f = r.read_field(last_id); f.t != compact_reader::STOP; f = r.read_field(last_id)) {
+        if (f.id == 1 && f.t == compact_reader::I32) {
+            h.num_values = r.read_i32();
+            num_values = true;
+        } else if (f.id == 2 && f.t == compact_reader::I32) {
+            h.num_nulls = r.read_i32();
+            num_nulls = true;
+        } else if (f.id == 3 && f.t == compact_reader::I32) {
+            h.num_rows = r.read_i32();
+            num_rows = true;
+        } else if (f.id == 4 && f.t == compact_reader::I32) {
+            h.encoding = static_cast<format::Encoding::type>(r.read_i32());
+            encoding = true;
+        } else if (f.id == 5 && f.t == compact_reader::I32) {
+            h.definition_levels_byte_length = r.read_i32();
+            definition_levels_byte_length = true;
+        } else if (f.id == 6 && f.t == compact_reader::I32) {
+            h.repetition_levels_byte_length = r.read_i32();
+            repetition_levels_byte_length = true;
+        } else if (f.id == 7 && (f.t == compact_reader::BOOLEAN_TRUE || f.t == compact_reader::BOOLEAN_FALSE)) {
+            h.is_compressed = f.t == compact_reader::BOOLEAN_TRUE;
+            h.__isset.is_compressed = true;
+        } else if (f.id == 8 && f.t == compact_reader::STRUCT) {
+            read_statistics(r, h.statistics);
+            h.__isset.statistics = true;
+        } else {
+            r.skip(f.t);
+        }
+    }
+    r.leave_struct();
+    check_required(r, num_values, "DataPageHeaderV2.num_values");
+    check_required(r, num_nulls, "DataPageHeaderV2.num_nulls");
+    check_required(r, num_rows, "DataPageHeaderV2.num_rows");
+    check_required(r, encoding, "DataPageHeaderV2.encoding");
+    check_required(r, definition_levels_byte_length, "DataPageHeaderV2.definition_levels_byte_length");
+    check_required(r, repetition_levels_byte_length, "DataPageHeaderV2.repetition_levels_byte_length");
+}
+
+void read_page_header(compact_reader& r, format::PageHeader& h) {
+    bool type = false;
+    bool uncompressed_page_size = false;
+    bool compressed_page_size = false;
+    r.enter_struct();
+    int16_t last_id = 0;
+    for (auto f = r.read_field(last_id); f.t != compact_reader::STOP; f = r.read_field(last_id)) {
+        if (f.id == 1 && f.t == compact_reader::I32) {
+            h.type = static_cast<format::PageType::type>(r.read_i32());
+            type = true;
+        } else if (f.id == 2 && f.t == compact_reader::I32) {
+            h.uncompressed_page_size = r.read_i32();
+            uncompressed_page_size = true;
+        } else if (f.id == 3 && f.t == compact_reader::I32) {
+            h.compressed_page_size = r.read_i32();
+            compressed_page_size = true;
+        } else if (f.id == 4 && f.t == compact_reader::I32) {
+            h.crc = r.read_i32();
+            h.__isset.crc = true;
+        } else if (f.id == 5 && f.t == compact_reader::STRUCT) {
+            read_data_page_header(r, h.data_page_header);
+            h.__isset.data_page_header = true;
+        } else if (f.id == 7 && f.t == compact_reader::STRUCT) {
+            read_dictionary_page_header(r, h.dictionary_page_header);
+            h.__isset.dictionary_page_header = true;
+        } else if (f.id == 8 && f.t == compact_reader::STRUCT) {
+            read_data_page_header_v2(r, h.data_page_header_v2);
+            h.__isset.data_page_header_v2 = true;
+        } else {
+            // IndexPageHeader has no fields, so index_page_header is skipped too.
+            r.skip(f.t);
+            h.__isset.index_page_header |= f.id == 6 && f.t == compact_reader::STRUCT;
+        }
+    }
+    r.leave_struct();
+    check_required(r, type, "PageHeader.type");
+    check_required(r, uncompressed_page_size, "PageHeader.uncompressed_page_size");
+    check_required(r, compressed_page_size, "PageHeader.compressed_page_size");
+}
+
+}  // namespace
+
+compact_struct_scanner::compact_struct_scanner() : _pending{compact_reader::STRUCT} {}
+
+// Record that the struct is at least n bytes longer than the current position, and return 0.
+size_t compact_struct_scanner::need(size_t n) {
+    // n may come from a length read from the data, so the sum saturates instead of overflowing.
+    size_t limit = std::numeric_limits<size_t>::max() - _pos;
+    _min_size = std::max(_min_size, n > limit ? std::numeric_limits<size_t>::max() : _pos + n);
+    return 0;
+}
+
+size_t compact_struct_scanner::scan(bytes_view data) {
+    using type = compact_reader::type;
+    // Read the varint at _pos + offset without consuming it. Return its size, or 0 if data ends before it does.
+    auto read_varint = [&data, this](size_t offset, uint64_t& value) -> size_t {
+        value = 0;
+        for (size_t i = 0; i < 10; ++i) {
+            if (_pos + offset + i >= data.size()) {
+                return 0;
+            }
+            uint8_t b = data[_pos + offset + i];
+            value |= static_cast<uint64_t>(b & 0x7f) << (7 * i);
+            if (!(b & 0x80)) {
+                return i + 1;
+            }
+        }
+        throw parquet_exception::corrupted_file("Varint too long in page header");
+    };
+    // The bytes left in data after _pos + offset, plus one.
+    auto more = [&data, this](size_t offset) { return data.size() + 1 - std::min(data.size(), _pos + offset); };
+    while (true) {
+        if (_pending != type::STOP) {
+            uint64_t value;
+            size_t n;
+            switch (_pending) {
+                case type::BOOLEAN_TRUE:
+                case type::BOOLEAN_FALSE:
+                case type::BYTE:
+                    // Boolean elements of containers take a byte each. Boolean fields are never pending.
+                    if (_pos >= data.size()) {
+                        return need(1);
+                    }
+                    _pos += 1;
+                    break;
+                case type::I16:
+                case type::I32:
+                case type::I64:
+                    if (!(n = read_varint(0, value))) {
+                        return need(more(0));
+                    }
+                    _pos += n;
+                    break;
+                case type::DOUBLE:
+                    // Skipped bytes don't have to be in data yet.
+                    _pos += 8;
+                    break;
+                case type::BINARY:
+                    if (!(n = read_varint(0, value))) {
+                        return need(more(0));
+                    }
+                    if (value > std::numeric_limits<size_t>::max() - _pos - n) {
+                        return need(std::numeric_limits<size_t>::max());
+                    }
+                    _pos += n + value;
+                    break;
+                case type::LIST:
+                case type::SET: {
+                    if (_pos >= data.size()) {
+                        return need(1);
+                    }
+                    uint8_t header = data[_pos];
+                    value = header >> 4;
+                    n = 1;
+                    if (value == 15) {
+                        size_t m = read_varint(1, value);
+                        if (!m) {
+                            return need(more(1) + 1);
+                        }
+                        n += m;
+                    }
+                    _stack.push_back(frame{type::LIST, 0, static_cast<uint8_t>(header & 0x0f), false, value});
+                    _pos += n;
+                    break;
+                }
+                case type::MAP:
+                    if (!(n = read_varint(0, value))) {
+                        return need(more(0));
+                    }
+                    if (value == 0) {
+                        _pos += n;
+                        break;
+                    }
+                    if (_pos + n >= data.size()) {
+                        return need(n + 1);
+                    }
+                    _stack.push_back(frame{type::MAP, static_cast<uint8_t>(data[_pos + n] >> 4),
+                                           static_cast<uint8_t>(data[_pos + n] & 0x0f), false, value});
+                    _pos += n + 1;
+                    break;
+                case type::STRUCT:
+                    _stack.push_back(frame{type::STRUCT, 0, 0});
+                    break;
+                default:
+                    throw parquet_exception::corrupted_file(
+                      seastar::format("Unknown thrift type {} in page header", static_cast<int>(_pending)));
+            }
+            if (_stack.size() > 64) {
+                throw parquet_exception::corrupted_file("Page header nested too deeply");
+            }
+            _pending = type::STOP;
+        }
+        if (_stack.empty()) {
+            return _pos;
+        }
+        frame& f = _stack.back();
+        if (f.kind == type::STRUCT) {
+            if (_pos >= data.size()) {
+                return need(1);
+            }
+            uint8_t header = data[_pos];
+            uint8_t t = header & 0x0f;
+            size_t n = 1;
+            if (t != type::STOP && header >> 4 == 0) {
+                // The field id follows as a varint, instead of a delta in the header.
+                uint64_t id;
+                size_t m = read_varint(1, id);
+                if (!m) {
+                    return need(more(1) + 1);
+                }
+                n += m;
+            }
+            _pos += n;
+            if (t == type::STOP) {
+                _stack.pop_back();
+            } else if (t != type::BOOLEAN_TRUE && t != type::BOOLEAN_FALSE) {
+                // The value of a boolean field is its type.
+                _pending = t;
+            }
+        } else if (f.remaining == 0) {
+            _stack.pop_back();
+        } else if (f.kind == type::LIST) {
+            --f.remaining;
+            _pending = f.value;
+        } else {
+            _pending = f.value_next ? f.value : f.key;
+            f.remaining -= f.value_next;
+            f.value_next = !f.value_next;
+        }
+    }
+}
+
+page_header_parse_result deserialize_page_header(bytes_view data, format::PageHeader& header) {
+    compact_reader r{data};
+    reset(header);
+    read_page_header(r, header);
+    if (r.truncated()) {
+        return {0, std::max(r.min_size(), data.size() + 1)};
+    }
+    return {r.consumed(), 0};
+}
+
+seastar::future<bool> read_page_header_from_stream(IPeekableStream& stream, format::PageHeader& header,
+                                                   size_t expected_size, size_t max_allowed_size) {
+    auto check_size = [max_allowed_size](size_t size) {
+        if (size > max_allowed_size) {
+            throw parquet_exception(
+              seastar::format("Could not deserialize thrift: max allowed size of {} exceeded", max_allowed_size));
+        }
+    };
+    auto parse = [&header](bytes_view peek) {
+        try {
+            return deserialize_page_header(peek, header);
+        } catch (const std::exception& e) {
+            throw parquet_exception(seastar::format("Could not deserialize thrift: {}", e.what()));
+        }
+    };
+    compact_struct_scanner scanner;
+    auto scan = [&scanner](bytes_view peek) {
+        try {
+            return scanner.scan(peek);
+        } catch (const std::exception& e) {
+            throw parquet_exception(seastar::format("Could not deserialize thrift: {}", e.what()));
+        }
+    };
+    auto check_end = [](bytes_view peek, size_t size) {
+        if (peek.size() < size) {
+            throw parquet_exception(
+              seastar::format("Could not deserialize thrift: unexpected end of stream at {}B", peek.size()));
+        }
+    };
+
+    check_size(expected_size);
+    bytes_view peek = co_await stream.peek(expected_size);
+    if (peek.empty()) {
+        co_return false;
+    }
+    page_header_parse_result result = parse(peek);
+    if (result.size == 0) {
+        // The header is bigger than expected. Find its exact size first, doubling the peek (or growing it
+        // to the known part of the header, if that is more) until the scanner reaches the end of the header.
+        // The scanner resumes where it stopped, so this scans each byte once. The end of the header
+        // is in the last peek, so the header is parsed once more, from it.
+        size_t size;
+        while ((size = scan(peek)) == 0) {
+            check_end(peek, expected_size);
+            expected_size = std::max(expected_size * 2, scanner.min_size());
+            check_size(expected_size);
+            peek = co_await stream.peek(expected_size);
+        }
+        result = parse(peek.substr(0, size));
+        if (result.size != size) {
+            throw parquet_exception(seastar::format(
+              "Could not deserialize thrift: page header of {}B parsed as {}B", size, result.size));
+        }
+    }
+    co_await stream.advance(result.size);
+    co_return true;
+}
+
 }  // namespace parquet4seastar
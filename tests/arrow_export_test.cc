@@ -0,0 +1,211 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+
+#include <parquet4seastar/arrow_export.hh>
+#include <seastar/testing/test_case.hh>
+
+namespace parquet4seastar {
+
+seastar::temporary_buffer<uint8_t> to_buffer(std::string_view s) {
+    return seastar::temporary_buffer<uint8_t>(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+}
+
+template <typename T>
+const T* buffer(const ArrowArray& array, size_t i) {
+    return static_cast<const T*>(array.buffers[i]);
+}
+
+SEASTAR_TEST_CASE(column_batch_export) {
+    format::SchemaElement info;
+
+    // optional int32 (DATE): 5, null, 7
+    {
+        reader_schema::schema root{info, {}, {}};
+        root.fields.push_back(reader_schema::primitive_node{{info, {"d"}, 1, 0}, logical_type::DATE{}, 0});
+        const auto& leaf = std::get<reader_schema::primitive_node>(root.fields[0]);
+        column_batch<format::Type::INT32> batch;
+        batch.rows = 3;
+        batch.values = {5, 0, 7};
+        for (bool valid : {true, false, true}) {
+            batch.validity.push_back(valid);
+        }
+        const int32_t* values = batch.values.data();
+        ArrowArray array;
+        ArrowSchema schema;
+        export_column_batch(std::move(batch), root, leaf, &array, &schema);
+        BOOST_CHECK_EQUAL(schema.format, "tdD");
+        BOOST_CHECK_EQUAL(schema.name, "d");
+        BOOST_CHECK_EQUAL(schema.n_children, 0);
+        BOOST_CHECK_EQUAL(array.length, 3);
+        BOOST_CHECK_EQUAL(array.null_count, 1);
+        BOOST_REQUIRE_EQUAL(array.n_buffers, 2);
+        BOOST_CHECK_EQUAL(*buffer<uint8_t>(array, 0), 0b101);
+        // Zero-copy: the exported buffer is the batch's own vector.
+        BOOST_CHECK_EQUAL(buffer<int32_t>(array, 1), values);
+        array.release(&array);
+        schema.release(&schema);
+        BOOST_CHECK(!array.release);
+        BOOST_CHECK(!schema.release);
+    }
+
+    // optional group (LIST) { repeated group list { required binary element (STRING) } }
+    // Rows: ["ab", "c"], null, []
+    {
+        reader_schema::schema root{info, {}, {}};
+        root.fields.push_back(reader_schema::list_node{
+          {info, {"s"}, 1, 0},
+          std::make_unique<reader_schema::node>(
+            reader_schema::primitive_node{{info, {"s", "list", "element"}, 2, 1}, logical_type::STRING{}, 0})});
+        const auto& leaf =
+          std::get<reader_schema::primitive_node>(*std::get<reader_schema::list_node>(root.fields[0]).element);
+        column_batch<format::Type::BYTE_ARRAY> batch;
+        batch.rows = 3;
+        batch.lists.resize(1);
+        batch.lists[0].offsets = {0, 2, 2, 2};
+        for (bool valid : {true, false, true}) {
+            batch.lists[0].validity.push_back(valid);
+        }
+        batch.values.push_back(to_buffer("ab"));
+        batch.values.push_back(to_buffer("c"));
+        ArrowArray array;
+        ArrowSchema schema;
+        export_column_batch(std::move(batch), root, leaf, &array, &schema);
+        BOOST_CHECK_EQUAL(schema.format, "+l");
+        BOOST_CHECK_EQUAL(schema.name, "s.list.element");
+        BOOST_REQUIRE_EQUAL(schema.n_children, 1);
+        BOOST_CHECK_EQUAL(schema.children[0]->format, "u");
+        BOOST_CHECK_EQUAL(array.length, 3);
+        BOOST_CHECK_EQUAL(array.null_count, 1);
+        BOOST_CHECK_EQUAL(buffer<int32_t>(array, 1)[3], 2);
+        BOOST_REQUIRE_EQUAL(array.n_children, 1);
+        const ArrowArray& strings = *array.children[0];
+        BOOST_CHECK_EQUAL(strings.length, 2);
+        BOOST_REQUIRE_EQUAL(strings.n_buffers, 3);
+        BOOST_CHECK(!strings.buffers[0]);
+        BOOST_CHECK_EQUAL(buffer<int32_t>(strings, 1)[2], 3);
+        BOOST_CHECK_EQUAL(std::string_view(buffer<char>(strings, 2), 3), "abc");
+        array.release(&array);
+        schema.release(&schema);
+    }
+
+    // A record batch of a DECIMAL column.
+    {
+        reader_schema::schema root{info, {}, {}};
+        root.fields.push_back(
+          reader_schema::primitive_node{{info, {"x"}, 0, 0}, logical_type::DECIMAL_INT64{2, 10}, 0});
+        const auto& leaf = std::get<reader_schema::primitive_node>(root.fields[0]);
+        column_batch<format::Type::INT64> batch;
+        batch.rows = 2;
+        batch.values = {-12345, 6789};
+        std::vector<any_column_batch> batches;
+        batches.push_back(std::move(batch));
+        ArrowArray array;
+        ArrowSchema schema;
+        export_record_batch(std::move(batches), root, {&leaf}, &array, &schema);
+        BOOST_CHECK_EQUAL(schema.format, "+s");
+        BOOST_REQUIRE_EQUAL(schema.n_children, 1);
+        BOOST_CHECK_EQUAL(schema.children[0]->format, "d:10,2");
+        BOOST_CHECK_EQUAL(array.length, 2);
+        BOOST_REQUIRE_EQUAL(array.n_children, 1);
+        BOOST_CHECK(buffer<__int128>(*array.children[0], 1)[0] == -12345);
+        array.release(&array);
+        schema.release(&schema);
+    }
+    return seastar::make_ready_future<>();
+}
+
+// Leaves of maps and structs can't be exported one at a time, so they are rejected.
+SEASTAR_TEST_CASE(column_batch_export_unsupported) {
+    format::SchemaElement map_info;
+    map_info.__set_name("m");
+    format::SchemaElement struct_info;
+    struct_info.__set_name("st");
+    format::SchemaElement info;
+
+    reader_schema::schema root{info, {}, {}};
+    root.fields.push_back(reader_schema::map_node{
+      {map_info, {"m"}, 1, 0},
+      std::make_unique<reader_schema::node>(
+        reader_schema::primitive_node{{info, {"m", "key_value", "key"}, 1, 1}, logical_type::STRING{}, 0}),
+      std::make_unique<reader_schema::node>(
+        reader_schema::primitive_node{{info, {"m", "key_value", "value"}, 2, 1}, logical_type::INT32{}, 1})});
+    reader_schema::struct_node st{{struct_info, {"st"}, 0, 0}, {}};
+    st.fields.push_back(reader_schema::primitive_node{{info, {"st", "a"}, 0, 0}, logical_type::INT32{}, 2});
+    root.fields.push_back(std::move(st));
+    const reader_schema::primitive_node stray{{info, {"stray"}, 0, 0}, logical_type::INT32{}, 3};
+
+    const auto& map = std::get<reader_schema::map_node>(root.fields[0]);
+    const auto& key = std::get<reader_schema::primitive_node>(*map.key);
+    const auto& value = std::get<reader_schema::primitive_node>(*map.value);
+    const auto& field =
+      std::get<reader_schema::primitive_node>(std::get<reader_schema::struct_node>(root.fields[1]).fields[0]);
+    for (const reader_schema::primitive_node* leaf : {&key, &value, &field, &stray}) {
+        ArrowArray array;
+        ArrowSchema schema;
+        column_batch<format::Type::INT32> batch;
+        BOOST_CHECK_THROW(export_column_batch(std::move(batch), root, *leaf, &array, &schema), parquet_exception);
+        std::vector<any_column_batch> batches;
+        batches.push_back(column_batch<format::Type::INT32>{});
+        BOOST_CHECK_THROW(export_record_batch(std::move(batches), root, {leaf}, &array, &schema), parquet_exception);
+    }
+    return seastar::make_ready_future<>();
+}
+
+// A failed export leaves nothing behind to release, even if it fails after some children were exported.
+SEASTAR_TEST_CASE(record_batch_export_failure) {
+    format::SchemaElement info;
+    reader_schema::schema root{info, {}, {}};
+    root.fields.push_back(reader_schema::primitive_node{{info, {"x"}, 0, 0}, logical_type::DECIMAL_INT64{2, 10}, 0});
+    root.fields.push_back(
+      reader_schema::primitive_node{{info, {"y"}, 0, 0}, logical_type::DECIMAL_BYTE_ARRAY{2, 20}, 1});
+    root.fields.push_back(
+      reader_schema::primitive_node{{info, {"z"}, 0, 0}, logical_type::DECIMAL_BYTE_ARRAY{2, 40}, 2});
+    const auto& x = std::get<reader_schema::primitive_node>(root.fields[0]);
+    const auto& y = std::get<reader_schema::primitive_node>(root.fields[1]);
+    const auto& z = std::get<reader_schema::primitive_node>(root.fields[2]);
+    auto make_batches = [] {
+        column_batch<format::Type::INT64> first;
+        first.rows = 1;
+        first.values = {-12345};
+        column_batch<format::Type::BYTE_ARRAY> second;
+        second.rows = 1;
+        second.values.push_back(to_buffer(std::string(17, '\x01')));
+        std::vector<any_column_batch> batches;
+        batches.push_back(std::move(first));
+        batches.push_back(std::move(second));
+        return batches;
+    };
+
+    // The 17 bytes of y don't fit in decimal128, which is found while converting them, after x is exported.
+    // z is DECIMAL(40, 2), which doesn't fit in decimal128 either, and is rejected before anything is exported.
+    for (const reader_schema::primitive_node* second_leaf : {&y, &z}) {
+        ArrowArray array;
+        ArrowSchema schema;
+        BOOST_CHECK_THROW(export_record_batch(make_batches(), root, {&x, second_leaf}, &array, &schema),
+                          parquet_exception);
+        BOOST_CHECK(!array.release);
+        BOOST_CHECK(!schema.release);
+    }
+    return seastar::make_ready_future<>();
+}
+
+}  // namespace parquet4seastar
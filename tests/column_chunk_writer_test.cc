@@ -106,4 +106,743 @@ SEASTAR_TEST_CASE(column_roundtrip) {
     });
 }
 
+// Batches bigger than the preemption check interval are decoded in several chunks.
+SEASTAR_TEST_CASE(column_roundtrip_large_batch) {
+    return seastar::async([] {
+        seastar::file output_file =
+          seastar::open_file_dma(test_file_name.data(),
+                                 seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create)
+            .get0();
+
+        constexpr size_t n_levels = 10000;
+        std::vector<int32_t> expected_def(n_levels);
+        std::vector<int32_t> expected_rep(n_levels, 0);
+        std::vector<int32_t> expected_val;
+        for (size_t i = 0; i < n_levels; ++i) {
+            expected_def[i] = (i % 3 != 0);
+            if (expected_def[i]) {
+                expected_val.push_back(i);
+            }
+        }
+
+        seastar::output_stream<char> output = seastar::make_file_output_stream(output_file).get0();
+        constexpr format::Type::type INT32 = format::Type::INT32;
+        column_chunk_writer<INT32> w{1, 0, make_value_encoder<INT32>(format::Encoding::DELTA_BINARY_PACKED),
+                                     compressor::make(format::CompressionCodec::UNCOMPRESSED)};
+        w.set_yield_hook([] { seastar::thread::yield(); });
+        w.put_batch(n_levels, expected_def.data(), expected_rep.data(), expected_val.data());
+        w.flush_chunk(output).get();
+        output.flush().get();
+        output.close().get();
+
+        seastar::file input_file = seastar::open_file_dma(test_file_name.data(), seastar::open_flags::ro).get0();
+        column_chunk_reader<INT32> r{page_reader{SeastarFile(input_file).make_peekable_stream()},
+                                     format::CompressionCodec::UNCOMPRESSED, 1, 0, std::nullopt};
+        std::vector<int32_t> def(n_levels);
+        std::vector<int32_t> rep(n_levels);
+        std::vector<int32_t> val(n_levels);
+        size_t n_read = r.read_batch(n_levels, def.data(), rep.data(), val.data()).get0();
+
+        BOOST_REQUIRE_EQUAL(n_read, n_levels);
+        BOOST_CHECK(def == expected_def);
+        BOOST_CHECK(rep == expected_rep);
+        val.resize(expected_val.size());
+        BOOST_CHECK(val == expected_val);
+        BOOST_CHECK_EQUAL(r.read_batch(n_levels, def.data(), rep.data(), val.data()).get0(), 0);
+
+        // Byte-sized levels.
+        column_chunk_reader<INT32> narrow{page_reader{SeastarFile(input_file).make_peekable_stream()},
+                                          format::CompressionCodec::UNCOMPRESSED, 1, 0, std::nullopt};
+        std::vector<uint8_t> narrow_def(n_levels);
+        std::vector<uint8_t> narrow_rep(n_levels);
+        val.resize(n_levels);
+        n_read = narrow.read_batch(n_levels, narrow_def.data(), narrow_rep.data(), val.data()).get0();
+        BOOST_REQUIRE_EQUAL(n_read, n_levels);
+        BOOST_CHECK(std::equal(narrow_def.begin(), narrow_def.end(), expected_def.begin(), expected_def.end()));
+        BOOST_CHECK(std::equal(narrow_rep.begin(), narrow_rep.end(), expected_rep.begin(), expected_rep.end()));
+        val.resize(expected_val.size());
+        BOOST_CHECK(val == expected_val);
+    });
+}
+
+struct int32_levels
+{
+    std::vector<int32_t> def;
+    std::vector<int32_t> rep;
+    std::vector<int32_t> val;
+
+    void append(const int32_levels& other) {
+        def.insert(def.end(), other.def.begin(), other.def.end());
+        rep.insert(rep.end(), other.rep.begin(), other.rep.end());
+        val.insert(val.end(), other.val.begin(), other.val.end());
+    }
+};
+
+// Nested: row i holds i % 3 + 1 levels. Every fourth level is null.
+int32_levels nested_row(size_t i) {
+    int32_levels row;
+    for (size_t j = 0; j < i % 3 + 1; ++j) {
+        row.def.push_back((i + j) % 4 != 0);
+        row.rep.push_back(j == 0 ? 0 : 1);
+        if (row.def.back()) {
+            row.val.push_back(i * 10 + j);
+        }
+    }
+    return row;
+}
+
+// Flat: every fifth row is null.
+int32_levels flat_row(size_t i) {
+    int32_levels row{{i % 5 != 0}, {0}, {}};
+    if (row.def[0]) {
+        row.val.push_back(i);
+    }
+    return row;
+}
+
+// A sync sink which collects the written bytes.
+struct memory_sink
+{
+    bytes data;
+
+    void write(const char* str, size_t len) { data.append(reinterpret_cast<const byte*>(str), len); }
+    void flush() {}
+    void close() {}
+};
+
+// A column chunk written to the test file by write_column, and read back by read_column.
+struct test_column
+{
+    uint32_t max_def = 1;
+    uint32_t max_rep = 0;
+    format::Encoding::type encoding = format::Encoding::PLAIN;
+    format::CompressionCodec::type codec = format::CompressionCodec::UNCOMPRESSED;
+    std::optional<uint32_t> type_length;
+    // A page ends every rows_per_page rows, and a chunk every rows_per_chunk rows.
+    size_t rows_per_page = SIZE_MAX;
+    size_t rows_per_chunk = SIZE_MAX;
+    compression_offload* offload = nullptr;
+    // Flush the chunks with sync_flush_chunk rather than flush_chunk.
+    bool sync_flush = false;
+};
+
+// Must be called from a seastar::thread. Writes rows [0, n_rows) to the test file, with put_row(w, i) putting
+// the levels and values of row i into the writer w. Return the metadata of each chunk.
+template <format::Type::type T, typename PutRow>
+std::vector<seastar::lw_shared_ptr<format::ColumnMetaData>> write_column(const test_column& c, size_t n_rows,
+                                                                         PutRow put_row) {
+    seastar::file output_file =
+      seastar::open_file_dma(test_file_name.data(),
+                             seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create)
+        .get0();
+    seastar::output_stream<char> output = seastar::make_file_output_stream(output_file).get0();
+    column_chunk_writer<T> w{c.max_def, c.max_rep, make_value_encoder<T>(c.encoding), compressor::make(c.codec),
+                             c.offload};
+    std::vector<seastar::lw_shared_ptr<format::ColumnMetaData>> chunks;
+    for (size_t i = 0; i < n_rows; ++i) {
+        put_row(w, i);
+        if ((i + 1) % c.rows_per_chunk == 0 || i + 1 == n_rows) {
+            if (c.sync_flush) {
+                memory_sink sink;
+                chunks.push_back(w.sync_flush_chunk(sink));
+                output.write(reinterpret_cast<const char*>(sink.data.data()), sink.data.size()).get();
+            } else {
+                chunks.push_back(w.flush_chunk(output).get0());
+            }
+        } else if ((i + 1) % c.rows_per_page == 0) {
+            w.flush_page();
+        }
+    }
+    output.flush().get();
+    output.close().get();
+    return chunks;
+}
+
+// Must be called from a seastar::thread. Opens a reader of the test file, or of the chunk of the given size
+// which starts at offset.
+template <format::Type::type T>
+column_chunk_reader<T> read_column(const test_column& c, uint64_t offset = 0, std::optional<uint64_t> size = {},
+                                   reader_memory_limiter* memory_limiter = nullptr) {
+    seastar::file input_file = seastar::open_file_dma(test_file_name.data(), seastar::open_flags::ro).get0();
+    SeastarFile file{input_file};
+    auto stream = size ? file.make_peekable_stream(offset, *size) : file.make_peekable_stream(offset);
+    return column_chunk_reader<T>{page_reader{std::move(stream)}, c.codec, c.max_def, c.max_rep, c.type_length,
+                                  nullptr, memory_limiter};
+}
+
+// Must be called from a seastar::thread.
+column_chunk_reader<format::Type::INT32> write_int32_column(uint32_t max_rep, size_t n_rows, size_t rows_per_page,
+                                                            int32_levels (*make_row)(size_t)) {
+    constexpr format::Type::type INT32 = format::Type::INT32;
+    test_column c{.max_rep = max_rep, .codec = format::CompressionCodec::SNAPPY, .rows_per_page = rows_per_page};
+    write_column<INT32>(c, n_rows, [make_row](column_chunk_writer<INT32>& w, size_t i) {
+        int32_levels row = make_row(i);
+        auto val = row.val.begin();
+        for (size_t j = 0; j < row.def.size(); ++j) {
+            w.put(row.def[j], row.rep[j], row.def[j] ? *val++ : 0);
+        }
+    });
+    return read_column<INT32>(c);
+}
+
+// Must be called from a seastar::thread.
+int32_levels read_all(column_chunk_reader<format::Type::INT32>& r) {
+    int32_levels out;
+    constexpr size_t batch_size = 16;
+    while (true) {
+        int32_t def[batch_size];
+        int32_t rep[batch_size];
+        int32_t val[batch_size];
+        size_t n_read = r.read_batch(batch_size, def, rep, val).get0();
+        if (n_read == 0) {
+            break;
+        }
+        out.def.insert(out.def.end(), def, def + n_read);
+        out.rep.insert(out.rep.end(), rep, rep + n_read);
+        out.val.insert(out.val.end(), val, val + std::count(def, def + n_read, 1));
+    }
+    return out;
+}
+
+// Pages of 25 rows: the first has no nulls, the second only nulls, the third is mixed.
+int32_levels constant_pages_row(size_t i) {
+    if (i < 25) {
+        return {{1}, {0}, {static_cast<int32_t>(i)}};
+    } else if (i < 50) {
+        return {{0}, {0}, {}};
+    }
+    return flat_row(i);
+}
+
+// Pages whose def levels are a single run are flagged, and read the same as the others.
+SEASTAR_TEST_CASE(column_constant_level_pages) {
+    return seastar::async([] {
+        auto r = write_int32_column(0, 75, 25, constant_pages_row);
+        BOOST_CHECK(!r.page_all_valid());
+        BOOST_CHECK(!r.page_all_null());
+        int32_levels expected;
+        int32_levels out;
+        std::vector<std::pair<bool, bool>> flags;
+        for (size_t i = 0; i < 75; ++i) {
+            expected.append(constant_pages_row(i));
+        }
+        while (true) {
+            int32_t def[10];
+            int32_t rep[10];
+            int32_t val[10];
+            size_t n_read = r.read_batch(10, def, rep, val).get0();
+            if (n_read == 0) {
+                break;
+            }
+            flags.emplace_back(r.page_all_valid(), r.page_all_null());
+            out.def.insert(out.def.end(), def, def + n_read);
+            out.rep.insert(out.rep.end(), rep, rep + n_read);
+            out.val.insert(out.val.end(), val, val + std::count(def, def + n_read, 1));
+        }
+        BOOST_CHECK(out.def == expected.def);
+        BOOST_CHECK(out.rep == expected.rep);
+        BOOST_CHECK(out.val == expected.val);
+        // Batches don't cross pages: 10, 10, 5 levels of each page.
+        BOOST_REQUIRE_EQUAL(flags.size(), 9);
+        BOOST_CHECK(flags[0] == std::make_pair(true, false));
+        BOOST_CHECK(flags[2] == std::make_pair(true, false));
+        BOOST_CHECK(flags[3] == std::make_pair(false, true));
+        BOOST_CHECK(flags[5] == std::make_pair(false, true));
+        BOOST_CHECK(flags[6] == std::make_pair(false, false));
+    });
+}
+
+// Flat optional columns can be read with a validity bitmap instead of def levels.
+SEASTAR_TEST_CASE(column_read_validity) {
+    return seastar::async([] {
+        int32_levels expected;
+        for (size_t i = 0; i < 100; ++i) {
+            expected.append(flat_row(i));
+        }
+        auto r = write_int32_column(0, 100, 25, flat_row);
+        std::vector<uint8_t> validity(13);
+        std::vector<int32_t> val(100);
+        size_t slots = 0;
+        size_t values = 0;
+        // Batches of 7 are not byte-aligned, and some cross page boundaries.
+        while (size_t n_read = r.read_batch_validity(7, validity.data(), slots, val.data() + values, &values).get0()) {
+            slots += n_read;
+        }
+        BOOST_REQUIRE_EQUAL(slots, 100);
+        for (size_t i = 0; i < slots; ++i) {
+            BOOST_CHECK_EQUAL(bool(validity[i / 8] & (1 << (i % 8))), expected.def[i] == 1);
+        }
+        val.resize(values);
+        BOOST_CHECK(val == expected.val);
+
+        auto nested = write_int32_column(1, 10, 10, nested_row);
+        BOOST_CHECK_THROW(nested.read_batch_validity(7, validity.data(), 0, val.data()).get0(), parquet_exception);
+    });
+}
+
+// Skipped rows are not returned. Flat pages which hold only skipped rows are dropped whole.
+SEASTAR_TEST_CASE(column_skip) {
+    return seastar::async([] {
+        int32_levels expected_nested;
+        for (size_t i = 7; i < 30; ++i) {
+            expected_nested.append(nested_row(i));
+        }
+        auto nested = write_int32_column(1, 30, 10, nested_row);
+        BOOST_CHECK_EQUAL(nested.skip(7).get0(), 7);
+        BOOST_CHECK_EQUAL(nested.skip(0).get0(), 0);
+        int32_levels nested_rest = read_all(nested);
+        BOOST_CHECK(nested_rest.def == expected_nested.def);
+        BOOST_CHECK(nested_rest.rep == expected_nested.rep);
+        BOOST_CHECK(nested_rest.val == expected_nested.val);
+        BOOST_CHECK_EQUAL(nested.skip(5).get0(), 0);
+
+        // 4 pages of 25 rows. The first two pages are dropped whole.
+        int32_levels expected_flat;
+        for (size_t i = 60; i < 100; ++i) {
+            expected_flat.append(flat_row(i));
+        }
+        auto flat = write_int32_column(0, 100, 25, flat_row);
+        BOOST_CHECK_EQUAL(flat.skip(60).get0(), 60);
+        int32_levels flat_rest = read_all(flat);
+        BOOST_CHECK(flat_rest.def == expected_flat.def);
+        BOOST_CHECK(flat_rest.rep == expected_flat.rep);
+        BOOST_CHECK(flat_rest.val == expected_flat.val);
+        BOOST_CHECK_EQUAL(flat.skip(1).get0(), 0);
+    });
+}
+
+SEASTAR_TEST_CASE(column_read_selected) {
+    return seastar::async([] {
+        // Rows 3, 4, 12, 13, 14, 25 and 28.
+        const uint8_t bitmap[] = {0b00011000, 0b01110000, 0b00000000, 0b00010010};
+        row_selection selection = row_selection::from_bitmap(bitmap, 30);
+        BOOST_CHECK(selection.ranges() == (std::vector<row_range>{{3, 5}, {12, 15}, {25, 26}, {28, 29}}));
+        BOOST_CHECK_EQUAL(selection.row_count(), 7);
+
+        for (auto make_row : {nested_row, flat_row}) {
+            int32_levels expected;
+            for (const row_range& range : selection.ranges()) {
+                for (size_t i = range.begin; i < range.end; ++i) {
+                    expected.append(make_row(i));
+                }
+            }
+            uint32_t max_rep = make_row == nested_row ? 1 : 0;
+            auto r = write_int32_column(max_rep, 30, 10, make_row);
+            std::vector<int32_t> def;
+            std::vector<int32_t> rep;
+            std::vector<int32_t> val;
+            BOOST_CHECK_EQUAL(r.read_selected(selection, def, rep, val).get0(), 7);
+            BOOST_CHECK(def == expected.def);
+            BOOST_CHECK(rep == expected.rep);
+            BOOST_CHECK(val == expected.val);
+        }
+
+        // Rows past the end of the chunk are not counted.
+        row_selection past_end;
+        past_end.add(28, 35);
+        auto r = write_int32_column(0, 30, 10, flat_row);
+        std::vector<int32_t> def;
+        std::vector<int32_t> rep;
+        std::vector<int32_t> val;
+        BOOST_CHECK_EQUAL(r.read_selected(past_end, def, rep, val).get0(), 2);
+    });
+}
+
+SEASTAR_TEST_CASE(column_read_indices) {
+    return seastar::async([] {
+        constexpr format::Type::type BYTE_ARRAY = format::Type::BYTE_ARRAY;
+        const bytes_view words[] = {"red"_bv, "green"_bv, "blue"_bv};
+        constexpr size_t n_levels = 100;
+        std::vector<int32_t> expected_def;
+        std::vector<bytes_view> expected_val;
+        test_column c{.encoding = format::Encoding::RLE_DICTIONARY, .rows_per_page = 51};
+        write_column<BYTE_ARRAY>(c, n_levels, [&](column_chunk_writer<BYTE_ARRAY>& w, size_t i) {
+            expected_def.push_back(i % 7 != 0);
+            if (expected_def.back()) {
+                expected_val.push_back(words[i % 3]);
+            }
+            w.put(expected_def.back(), 0, words[i % 3]);
+        });
+
+        reader_memory_limiter limiter{1024 * 1024};
+        auto r = read_column<BYTE_ARRAY>(c, 0, {}, &limiter);
+        size_t dictionary_changes = 0;
+        r.on_dictionary_change([&](const auto& dict) {
+            BOOST_CHECK_EQUAL(dict->size(), 3);
+            ++dictionary_changes;
+        });
+        std::vector<int32_t> def(n_levels);
+        std::vector<int32_t> rep(n_levels);
+        std::vector<uint32_t> idx(n_levels);
+        size_t levels_read = 0;
+        size_t values_read = 0;
+        while (size_t n_read = r.read_batch_indices(n_levels - levels_read, def.data() + levels_read,
+                                                    rep.data() + levels_read, idx.data() + values_read)
+                                 .get0()) {
+            values_read += std::count(def.begin() + levels_read, def.begin() + levels_read + n_read, 1);
+            levels_read += n_read;
+        }
+        BOOST_CHECK(r.dictionary_encoded());
+        BOOST_CHECK_EQUAL(dictionary_changes, 1);
+        BOOST_REQUIRE_EQUAL(levels_read, n_levels);
+        BOOST_CHECK(def == expected_def);
+        BOOST_REQUIRE_EQUAL(values_read, expected_val.size());
+        auto dict = r.dictionary();
+        for (size_t i = 0; i < values_read; ++i) {
+            const auto& value = (*dict)[idx[i]];
+            BOOST_CHECK(bytes_view(value.get(), value.size()) == expected_val[i]);
+        }
+
+        // The dictionary stays charged until its last handle is gone, even after the reader is.
+        { auto destroyed = std::move(r); }
+        BOOST_CHECK_GT(limiter.used(), 0);
+        dict.reset();
+        BOOST_CHECK_EQUAL(limiter.used(), 0);
+    });
+}
+
+SEASTAR_TEST_CASE(column_read_contiguous) {
+    return seastar::async([] {
+        constexpr format::Type::type BYTE_ARRAY = format::Type::BYTE_ARRAY;
+        const bytes_view words[] = {"x"_bv, ""_bv, "yy"_bv, "zzzz"_bv, "x"_bv};
+        constexpr size_t n_levels = 500;
+        for (format::Encoding::type encoding : {format::Encoding::PLAIN, format::Encoding::RLE_DICTIONARY}) {
+            std::vector<bytes_view> expected;
+            test_column c{.encoding = encoding, .codec = format::CompressionCodec::SNAPPY, .rows_per_page = 200};
+            write_column<BYTE_ARRAY>(c, n_levels, [&](column_chunk_writer<BYTE_ARRAY>& w, size_t i) {
+                bool defined = i % 4 != 0;
+                if (defined) {
+                    expected.push_back(words[i % 5]);
+                }
+                w.put(defined, 0, words[i % 5]);
+            });
+
+            auto r = read_column<BYTE_ARRAY>(c);
+            std::vector<int32_t> def(n_levels);
+            std::vector<int32_t> rep(n_levels);
+            byte_array_arena<int32_t> val;
+            size_t levels_read = 0;
+            while (size_t n_read = r.read_batch(std::min<size_t>(n_levels - levels_read, 64), def.data() + levels_read,
+                                                rep.data() + levels_read, val)
+                                     .get0()) {
+                levels_read += n_read;
+            }
+            BOOST_CHECK_EQUAL(levels_read, n_levels);
+            BOOST_REQUIRE_EQUAL(val.size(), expected.size());
+            for (size_t i = 0; i < val.size(); ++i) {
+                BOOST_CHECK(val[i] == expected[i]);
+            }
+        }
+    });
+}
+
+SEASTAR_TEST_CASE(column_read_fixed) {
+    return seastar::async([] {
+        constexpr format::Type::type FLBA = format::Type::FIXED_LEN_BYTE_ARRAY;
+        // DECIMAL(38, 0) values -12345 and 6789, as 16-byte big-endian two's complement integers.
+        const uint8_t decimals[2][16] = {
+          {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcf, 0xc7},
+          {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1a, 0x85},
+        };
+        constexpr size_t n_levels = 300;
+        for (format::Encoding::type encoding : {format::Encoding::PLAIN, format::Encoding::RLE_DICTIONARY}) {
+            std::vector<__int128> expected;
+            test_column c{.encoding = encoding, .type_length = 16, .rows_per_page = 100};
+            write_column<FLBA>(c, n_levels, [&](column_chunk_writer<FLBA>& w, size_t i) {
+                bool defined = i % 3 != 0;
+                if (defined) {
+                    expected.push_back(i % 2 ? 6789 : -12345);
+                }
+                w.put(defined, 0, bytes_view{decimals[i % 2], 16});
+            });
+
+            auto r = read_column<FLBA>(c);
+            std::vector<int32_t> def(n_levels);
+            std::vector<int32_t> rep(n_levels);
+            std::vector<uint8_t> dense(n_levels * 16);
+            fixed_len_buffer val{dense.data()};
+            size_t levels_read = 0;
+            while (size_t n_read = r.read_batch(n_levels - levels_read, def.data() + levels_read,
+                                                rep.data() + levels_read, val)
+                                     .get0()) {
+                levels_read += n_read;
+            }
+            BOOST_CHECK_EQUAL(levels_read, n_levels);
+            BOOST_REQUIRE_EQUAL(val.size, expected.size());
+            std::vector<__int128> decoded(val.size);
+            decode_decimals(dense.data(), 16, val.size, decoded.data());
+            BOOST_CHECK(decoded == expected);
+        }
+    });
+}
+
+// The value decoder is kept across the pages of a chunk, and reset in place when their encoding changes.
+// Pages 0 and 1 are dictionary-encoded. Page 2 grows the dictionary past the fallback threshold,
+// so pages 3 and 4 are PLAIN.
+SEASTAR_TEST_CASE(column_roundtrip_encoding_change) {
+    return seastar::async([] {
+        constexpr format::Type::type BYTE_ARRAY = format::Type::BYTE_ARRAY;
+        constexpr size_t n_pages = 5;
+        constexpr size_t levels_per_page = 100;
+        constexpr size_t n_levels = n_pages * levels_per_page;
+        std::vector<std::string> strings;
+        std::vector<int32_t> expected_def;
+        for (size_t i = 0; i < n_levels; ++i) {
+            size_t page = i / levels_per_page;
+            if (page == 2) {
+                // 100 distinct strings of 200 bytes.
+                strings.push_back(std::string(200, 'a' + i % 26) + std::to_string(i));
+            } else {
+                strings.push_back(std::string(i % 10, 'x'));
+            }
+            expected_def.push_back(i % 7 != 0);
+        }
+        std::vector<bytes_view> expected_val;
+        for (size_t i = 0; i < n_levels; ++i) {
+            if (expected_def[i]) {
+                const std::string& str = strings[i];
+                expected_val.push_back(bytes_view{reinterpret_cast<const uint8_t*>(str.data()), str.size()});
+            }
+        }
+
+        test_column c{.encoding = format::Encoding::RLE_DICTIONARY,
+                      .codec = format::CompressionCodec::SNAPPY,
+                      .rows_per_page = levels_per_page};
+        auto cmd = write_column<BYTE_ARRAY>(c, n_levels, [&](column_chunk_writer<BYTE_ARRAY>& w, size_t i) {
+            const std::string& str = strings[i];
+            w.put(expected_def[i], 0, bytes_view{reinterpret_cast<const uint8_t*>(str.data()), str.size()});
+        })[0];
+        BOOST_CHECK(std::count(cmd->encodings.begin(), cmd->encodings.end(), format::Encoding::PLAIN) == 1);
+        BOOST_CHECK(std::count(cmd->encodings.begin(), cmd->encodings.end(), format::Encoding::RLE_DICTIONARY) == 1);
+
+        // Batches don't cross pages, so each batch reports the encoding of its page.
+        std::vector<bool> expected_dictionary_encoded;
+        for (size_t page = 0; page < n_pages; ++page) {
+            for (size_t batch = 0; batch < (levels_per_page + 31) / 32; ++batch) {
+                expected_dictionary_encoded.push_back(page < 3);
+            }
+        }
+
+        // Owning values.
+        {
+            auto r = read_column<BYTE_ARRAY>(c);
+            std::vector<int32_t> def(n_levels);
+            std::vector<int32_t> rep(n_levels);
+            std::vector<seastar::temporary_buffer<uint8_t>> val(n_levels);
+            std::vector<bool> dictionary_encoded;
+            size_t levels_read = 0;
+            size_t values_read = 0;
+            while (size_t n_read = r.read_batch(32, def.data() + levels_read, rep.data() + levels_read,
+                                                val.data() + values_read)
+                                     .get0()) {
+                dictionary_encoded.push_back(r.dictionary_encoded());
+                values_read += std::count(def.begin() + levels_read, def.begin() + levels_read + n_read, 1);
+                levels_read += n_read;
+            }
+            BOOST_CHECK_EQUAL(levels_read, n_levels);
+            BOOST_CHECK(def == expected_def);
+            BOOST_CHECK(dictionary_encoded == expected_dictionary_encoded);
+            BOOST_REQUIRE_EQUAL(values_read, expected_val.size());
+            for (size_t i = 0; i < values_read; ++i) {
+                BOOST_CHECK(bytes_view(val[i].get(), val[i].size()) == expected_val[i]);
+            }
+        }
+
+        // Contiguous values.
+        {
+            auto r = read_column<BYTE_ARRAY>(c);
+            std::vector<int32_t> def(n_levels);
+            std::vector<int32_t> rep(n_levels);
+            byte_array_arena<int32_t> val;
+            size_t levels_read = 0;
+            while (size_t n_read = r.read_batch(32, def.data() + levels_read, rep.data() + levels_read, val).get0()) {
+                levels_read += n_read;
+            }
+            BOOST_CHECK_EQUAL(levels_read, n_levels);
+            BOOST_CHECK(def == expected_def);
+            BOOST_REQUIRE_EQUAL(val.size(), expected_val.size());
+            for (size_t i = 0; i < val.size(); ++i) {
+                BOOST_CHECK(val[i] == expected_val[i]);
+            }
+        }
+    });
+}
+
+template <format::Type::type T>
+struct kernel_test_values
+{
+    using value_type = typename column_chunk_reader<T>::output_type;
+    static value_type make(size_t i) { return static_cast<value_type>(i % 13) - 5; }
+    static value_type input(const value_type& v) { return v; }
+    static bool equal(const value_type& out, const value_type& expected) { return out == expected; }
+};
+
+template <>
+struct kernel_test_values<format::Type::BYTE_ARRAY>
+{
+    using value_type = std::string;
+    static std::string make(size_t i) { return std::string(i % 13, 'a' + i % 3); }
+    static bytes_view input(const std::string& v) {
+        return {reinterpret_cast<const uint8_t*>(v.data()), v.size()};
+    }
+    static bool equal(const seastar::temporary_buffer<uint8_t>& out, const std::string& expected) {
+        return bytes_view(out.get(), out.size()) == input(expected);
+    }
+};
+
+/* Must be called from a seastar::thread. Writes three pages, which select different page kernels:
+ * 1. Mixed levels, decoded from RLE runs.
+ * 2. Single-level rows, all non-null: both levels are a single run.
+ * 3. Single-level rows, all null: both levels are a single run (of 0).
+ * Then reads them back with LevelT levels.
+ */
+template <format::Type::type T, typename LevelT>
+void test_page_kernels(format::Encoding::type encoding, uint32_t max_def, uint32_t max_rep) {
+    using values = kernel_test_values<T>;
+    constexpr size_t rows_per_page = 40;
+    std::vector<LevelT> expected_def;
+    std::vector<LevelT> expected_rep;
+    std::vector<typename values::value_type> expected_val;
+
+    test_column c{.max_def = max_def, .max_rep = max_rep, .encoding = encoding, .rows_per_page = rows_per_page};
+    write_column<T>(c, 3 * rows_per_page, [&](column_chunk_writer<T>& w, size_t i) {
+        auto put = [&](uint32_t def, uint32_t rep) {
+            auto value = values::make(expected_def.size());
+            expected_def.push_back(def);
+            expected_rep.push_back(rep);
+            if (def == max_def) {
+                expected_val.push_back(value);
+            }
+            w.put(def, rep, values::input(value));
+        };
+        size_t page = i / rows_per_page;
+        if (page == 0) {
+            size_t row_levels = max_rep > 0 ? i % 3 + 1 : 1;
+            for (size_t j = 0; j < row_levels; ++j) {
+                put((i + j) % (max_def + 1), j == 0 ? 0 : 1 + j % max_rep);
+            }
+        } else {
+            put(page == 1 ? max_def : 0, 0);
+        }
+    });
+
+    auto r = read_column<T>(c);
+    size_t n_levels = expected_def.size();
+    std::vector<LevelT> def(n_levels);
+    std::vector<LevelT> rep(n_levels);
+    std::vector<typename column_chunk_reader<T>::output_type> val(n_levels);
+    size_t levels_read = 0;
+    size_t values_read = 0;
+    while (size_t n_read =
+             r.read_batch(16, def.data() + levels_read, rep.data() + levels_read, val.data() + values_read).get0()) {
+        values_read += std::count(def.begin() + levels_read, def.begin() + levels_read + n_read, max_def);
+        levels_read += n_read;
+    }
+
+    std::string context = seastar::format("type {}, encoding {}, max def {}, max rep {}, level width {}",
+                                          static_cast<int>(T), static_cast<int>(encoding), max_def, max_rep,
+                                          sizeof(LevelT));
+    BOOST_CHECK_MESSAGE(levels_read == n_levels, context);
+    BOOST_CHECK_MESSAGE(def == expected_def, context);
+    BOOST_CHECK_MESSAGE(rep == expected_rep, context);
+    BOOST_REQUIRE_MESSAGE(values_read == expected_val.size(), context);
+    for (size_t i = 0; i < values_read; ++i) {
+        BOOST_CHECK_MESSAGE(values::equal(val[i], expected_val[i]), context);
+    }
+}
+
+// Every page kernel which the writer can produce pages for: levels which are absent, a single run,
+// or RLE-encoded (def and rep separately), with PLAIN, dictionary and other (DELTA_BINARY_PACKED) values.
+SEASTAR_TEST_CASE(column_page_kernels) {
+    return seastar::async([] {
+        constexpr format::Type::type INT32 = format::Type::INT32;
+        constexpr format::Type::type INT64 = format::Type::INT64;
+        constexpr format::Type::type DOUBLE = format::Type::DOUBLE;
+        constexpr format::Type::type BYTE_ARRAY = format::Type::BYTE_ARRAY;
+        const std::pair<uint32_t, uint32_t> shapes[] = {{0, 0}, {1, 0}, {3, 0}, {1, 1}, {3, 2}};
+        for (auto [max_def, max_rep] : shapes) {
+            for (format::Encoding::type encoding : {format::Encoding::PLAIN, format::Encoding::RLE_DICTIONARY,
+                                                    format::Encoding::DELTA_BINARY_PACKED}) {
+                test_page_kernels<INT32, int32_t>(encoding, max_def, max_rep);
+                test_page_kernels<INT64, uint8_t>(encoding, max_def, max_rep);
+            }
+            for (format::Encoding::type encoding : {format::Encoding::PLAIN, format::Encoding::RLE_DICTIONARY}) {
+                test_page_kernels<DOUBLE, int16_t>(encoding, max_def, max_rep);
+                test_page_kernels<BYTE_ARRAY, int32_t>(encoding, max_def, max_rep);
+            }
+        }
+    });
+}
+
+// All pages are compressed after the fact, on the worker threads or inline. The same writer writes two chunks,
+// so the second one reuses the page buffers of the first.
+SEASTAR_TEST_CASE(column_roundtrip_offload) {
+    return seastar::async([] {
+        constexpr format::Type::type INT32 = format::Type::INT32;
+        constexpr size_t n_chunks = 2;
+        constexpr size_t rows_per_chunk = 300;
+        compression_offload offload{{.threshold = 1, .worker_threads = 2, .max_queued = 2}};
+        for (bool sync : {false, true}) {
+            int32_levels expected[n_chunks];
+            test_column c{.codec = format::CompressionCodec::GZIP,
+                          .rows_per_page = 100,
+                          .rows_per_chunk = rows_per_chunk,
+                          .offload = &offload,
+                          .sync_flush = sync};
+            auto cmd = write_column<INT32>(c, n_chunks * rows_per_chunk, [&](column_chunk_writer<INT32>& w, size_t i) {
+                int32_levels row = flat_row(i);
+                w.put(row.def[0], 0, row.def[0] ? row.val[0] : 0);
+                expected[i / rows_per_chunk].append(row);
+            });
+            BOOST_REQUIRE_EQUAL(cmd.size(), n_chunks);
+
+            uint64_t offset = 0;
+            for (size_t chunk = 0; chunk < n_chunks; ++chunk) {
+                BOOST_CHECK_EQUAL(cmd[chunk]->codec, format::CompressionCodec::GZIP);
+                BOOST_CHECK_EQUAL(cmd[chunk]->num_values, rows_per_chunk);
+                uint64_t size = cmd[chunk]->total_compressed_size;
+                auto r = read_column<INT32>(c, offset, size);
+                int32_levels out = read_all(r);
+                BOOST_CHECK(out.def == expected[chunk].def);
+                BOOST_CHECK(out.rep == expected[chunk].rep);
+                BOOST_CHECK(out.val == expected[chunk].val);
+                offset += size;
+            }
+        }
+        offload.stop().get();
+    });
+}
+
+// Deferred pages count towards the estimated chunk size as compressed, not as raw data.
+SEASTAR_TEST_CASE(column_offload_size_estimate) {
+    return seastar::async([] {
+        constexpr format::Type::type INT32 = format::Type::INT32;
+        compression_offload offload{{.threshold = 1, .worker_threads = 1, .max_queued = 1}};
+        column_chunk_writer<INT32> inline_writer{0, 0, make_value_encoder<INT32>(format::Encoding::PLAIN),
+                                                 compressor::make(format::CompressionCodec::GZIP)};
+        column_chunk_writer<INT32> offload_writer{0, 0, make_value_encoder<INT32>(format::Encoding::PLAIN),
+                                                  compressor::make(format::CompressionCodec::GZIP), &offload};
+        for (size_t chunk = 0; chunk < 2; ++chunk) {
+            for (int32_t i = 0; i < 10000; ++i) {
+                inline_writer.put(0, 0, i % 16);
+                offload_writer.put(0, 0, i % 16);
+                if (i % 1000 == 999) {
+                    inline_writer.flush_page();
+                    offload_writer.flush_page();
+                }
+            }
+            size_t expected = inline_writer.estimated_chunk_size();
+            size_t estimated = offload_writer.estimated_chunk_size();
+            BOOST_CHECK_LT(expected, 10000 * sizeof(int32_t) / 4);
+            BOOST_CHECK_GE(estimated, expected / 2);
+            BOOST_CHECK_LE(estimated, expected * 2);
+            memory_sink sink;
+            inline_writer.sync_flush_chunk(sink);
+            offload_writer.sync_flush_chunk(sink);
+            BOOST_CHECK_EQUAL(offload_writer.estimated_chunk_size(), 0);
+        }
+        offload.stop().get();
+    });
+}
+
 }  // namespace parquet4seastar
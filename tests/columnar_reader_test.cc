@@ -0,0 +1,127 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+
+#include <parquet4seastar/column_chunk_writer.hh>
+#include <parquet4seastar/columnar_reader.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/testing/test_case.hh>
+
+namespace parquet4seastar {
+
+constexpr std::string_view test_file_name = "/tmp/parquet4seastar_columnar_reader_test.bin";
+
+struct test_level
+{
+    uint32_t def;
+    uint32_t rep;
+    int32_t val;
+};
+
+// Must be called from a seastar::thread.
+column_chunk_reader<format::Type::INT32> write_column(uint32_t max_def, uint32_t max_rep,
+                                                      const std::vector<test_level>& levels) {
+    constexpr format::Type::type INT32 = format::Type::INT32;
+    seastar::file output_file =
+      seastar::open_file_dma(test_file_name.data(),
+                             seastar::open_flags::wo | seastar::open_flags::truncate | seastar::open_flags::create)
+        .get0();
+    seastar::output_stream<char> output = seastar::make_file_output_stream(output_file).get0();
+    column_chunk_writer<INT32> w{max_def, max_rep, make_value_encoder<INT32>(format::Encoding::PLAIN),
+                                 compressor::make(format::CompressionCodec::UNCOMPRESSED)};
+    for (const test_level& l : levels) {
+        w.put(l.def, l.rep, l.val);
+    }
+    w.flush_chunk(output).get();
+    output.flush().get();
+    output.close().get();
+
+    seastar::file input_file = seastar::open_file_dma(test_file_name.data(), seastar::open_flags::ro).get0();
+    return column_chunk_reader<INT32>{page_reader{SeastarFile(input_file).make_peekable_stream()},
+                                      format::CompressionCodec::UNCOMPRESSED, max_def, max_rep, std::nullopt};
+}
+
+std::vector<bool> to_vector(const validity_bitmap& bitmap) {
+    std::vector<bool> v;
+    for (size_t i = 0; i < bitmap.size(); ++i) {
+        v.push_back(bitmap[i]);
+    }
+    return v;
+}
+
+SEASTAR_TEST_CASE(column_batches) {
+    return seastar::async([] {
+        constexpr format::Type::type INT32 = format::Type::INT32;
+
+        // optional int32: 5, null, 7
+        column_shape flat_shape{{}, 1};
+        column_batch_reader<INT32> flat{write_column(1, 0, {{1, 0, 5}, {0, 0, 0}, {1, 0, 7}}), flat_shape};
+        column_batch<INT32> flat_batch = flat.read_batch(2).get0();
+        BOOST_CHECK_EQUAL(flat_batch.rows, 2);
+        BOOST_CHECK(flat_batch.lists.empty());
+        BOOST_CHECK_EQUAL(flat_batch.values.size(), 2);
+        BOOST_CHECK_EQUAL(flat_batch.values[0], 5);
+        BOOST_CHECK(to_vector(flat_batch.validity) == (std::vector<bool>{true, false}));
+        BOOST_CHECK_EQUAL(flat_batch.validity.null_count(), 1);
+        flat_batch = flat.read_batch(2).get0();
+        BOOST_CHECK_EQUAL(flat_batch.rows, 1);
+        BOOST_CHECK(flat_batch.values == (std::vector<int32_t>{7}));
+        BOOST_CHECK_EQUAL(flat.read_batch(2).get0().rows, 0);
+
+        // optional group (LIST) { repeated group list { optional int32 element } }
+        // Rows: [1, null, 2], null, [], [4]
+        column_shape list_shape{{{2, 1}}, 3};
+        column_batch_reader<INT32> nested{
+          write_column(3, 1, {{3, 0, 1}, {2, 1, 0}, {3, 1, 2}, {0, 0, 0}, {1, 0, 0}, {3, 0, 4}}), list_shape};
+        column_batch<INT32> nested_batch = nested.read_batch(10).get0();
+        BOOST_CHECK_EQUAL(nested_batch.rows, 4);
+        BOOST_REQUIRE_EQUAL(nested_batch.lists.size(), 1);
+        BOOST_CHECK(nested_batch.lists[0].offsets == (std::vector<int32_t>{0, 3, 3, 3, 4}));
+        BOOST_CHECK(to_vector(nested_batch.lists[0].validity) == (std::vector<bool>{true, false, true, true}));
+        BOOST_REQUIRE_EQUAL(nested_batch.values.size(), 4);
+        BOOST_CHECK_EQUAL(nested_batch.values[0], 1);
+        BOOST_CHECK_EQUAL(nested_batch.values[2], 2);
+        BOOST_CHECK_EQUAL(nested_batch.values[3], 4);
+        BOOST_CHECK(to_vector(nested_batch.validity) == (std::vector<bool>{true, false, true, true}));
+
+        // A list of lists: optional group (LIST) { repeated group list { optional group element (LIST) {
+        //     repeated group list { optional int32 element } } } }
+        // Rows: [[1, null], [], null], null, [[2]]
+        column_shape list_list_shape{{{2, 1}, {4, 3}}, 5};
+        column_batch_reader<INT32> deep{
+          write_column(5, 2, {{5, 0, 1}, {4, 2, 0}, {3, 1, 0}, {2, 1, 0}, {0, 0, 0}, {5, 0, 2}}), list_list_shape};
+        column_batch<INT32> deep_batch = deep.read_batch(10).get0();
+        BOOST_CHECK_EQUAL(deep_batch.rows, 3);
+        BOOST_REQUIRE_EQUAL(deep_batch.lists.size(), 2);
+        BOOST_CHECK(deep_batch.lists[0].offsets == (std::vector<int32_t>{0, 3, 3, 4}));
+        BOOST_CHECK(to_vector(deep_batch.lists[0].validity) == (std::vector<bool>{true, false, true}));
+        BOOST_CHECK(deep_batch.lists[1].offsets == (std::vector<int32_t>{0, 2, 2, 2, 3}));
+        BOOST_CHECK(to_vector(deep_batch.lists[1].validity) == (std::vector<bool>{true, true, false, true}));
+        BOOST_CHECK_EQUAL(deep_batch.lists[1].validity.null_count(), 1);
+        BOOST_REQUIRE_EQUAL(deep_batch.values.size(), 3);
+        BOOST_CHECK_EQUAL(deep_batch.values[0], 1);
+        BOOST_CHECK_EQUAL(deep_batch.values[2], 2);
+        BOOST_CHECK(to_vector(deep_batch.validity) == (std::vector<bool>{true, false, true}));
+    });
+}
+
+}  // namespace parquet4seastar
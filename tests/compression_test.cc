@@ -20,6 +20,7 @@
  */
 
 #include <parquet4seastar/compression.hh>
+#include <parquet4seastar/compression_offload.hh>
 #include <parquet4seastar/exception.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/testing/test_case.hh>
@@ -56,10 +57,120 @@ SEASTAR_TEST_CASE(compression_gzip) {
     return seastar::async([]() {});
 }
 
+SEASTAR_TEST_CASE(compression_gzip_levels) {
+    bytes raw;
+    for (size_t i = 0; i < 70000; ++i) {
+        raw.push_back(static_cast<byte>(i % 251));
+    }
+    // Interleave levels, so that the per-shard streams are reused and reset between pages.
+    for (int level : {1, 9, -1, 0, 1}) {
+        auto c = compressor::make(format::CompressionCodec::GZIP, {.level = level});
+        bytes compressed = c->compress(raw);
+        bytes decompressed = c->decompress(compressed, bytes(raw.size(), 0));
+        BOOST_CHECK(raw == decompressed);
+    }
+    BOOST_CHECK_THROW(compressor::make(format::CompressionCodec::GZIP, {.level = 10}), parquet_exception);
+    return seastar::async([]() {});
+}
+
 SEASTAR_TEST_CASE(compression_snappy) {
     test_compression_happy(format::CompressionCodec::SNAPPY);
     test_compression_overflow(format::CompressionCodec::SNAPPY);
     return seastar::async([]() {});
 }
 
+SEASTAR_TEST_CASE(compression_lz4_raw) {
+    test_compression_happy(format::CompressionCodec::LZ4_RAW);
+    test_compression_overflow(format::CompressionCodec::LZ4_RAW);
+    return seastar::async([]() {});
+}
+
+SEASTAR_TEST_CASE(compression_lz4) {
+    test_compression_happy(format::CompressionCodec::LZ4);
+    test_compression_overflow(format::CompressionCodec::LZ4);
+
+    // Older writers used the LZ4 codec id for raw, unframed LZ4 blocks.
+    bytes raw;
+    for (size_t i = 0; i < 1000; ++i) {
+        raw.push_back(static_cast<byte>(i % 7));
+    }
+    bytes unframed = compressor::make(format::CompressionCodec::LZ4_RAW)->compress(raw);
+    bytes decompressed = compressor::make(format::CompressionCodec::LZ4)->decompress(unframed, bytes(raw.size(), 0));
+    BOOST_CHECK(raw == decompressed);
+    return seastar::async([]() {});
+}
+
+SEASTAR_TEST_CASE(compression_brotli) {
+    test_compression_happy(format::CompressionCodec::BROTLI);
+    test_compression_overflow(format::CompressionCodec::BROTLI);
+    return seastar::async([]() {});
+}
+
+SEASTAR_TEST_CASE(compression_brotli_options) {
+    bytes raw;
+    for (size_t i = 0; i < 70000; ++i) {
+        raw.push_back(static_cast<byte>(i % 251));
+    }
+    auto c = compressor::make(format::CompressionCodec::BROTLI, {.level = 1, .window_bits = 10});
+    bytes compressed = c->compress(raw);
+    bytes decompressed = c->decompress(compressed, bytes(raw.size(), 0));
+    BOOST_CHECK(raw == decompressed);
+
+    BOOST_CHECK_THROW(compressor::make(format::CompressionCodec::BROTLI, {.level = 12}), parquet_exception);
+    BOOST_CHECK_THROW(compressor::make(format::CompressionCodec::BROTLI, {.window_bits = 25}), parquet_exception);
+    return seastar::async([]() {});
+}
+
+SEASTAR_TEST_CASE(compression_into_buffers) {
+    bytes raw;
+    for (size_t i = 0; i < 70000; ++i) {
+        raw.push_back(static_cast<byte>(i % 13));
+    }
+    for (auto codec : {format::CompressionCodec::UNCOMPRESSED, format::CompressionCodec::GZIP,
+                       format::CompressionCodec::SNAPPY, format::CompressionCodec::LZ4_RAW,
+                       format::CompressionCodec::LZ4, format::CompressionCodec::BROTLI}) {
+        auto c = compressor::make(codec);
+        auto compressed = std::make_unique_for_overwrite<byte[]>(c->max_compressed_size(raw.size()));
+        size_t compressed_size =
+          c->compress(raw, std::span<byte>{compressed.get(), c->max_compressed_size(raw.size())});
+        BOOST_CHECK_LE(compressed_size, c->max_compressed_size(raw.size()));
+
+        // The output buffer is intentionally left uninitialized.
+        auto decompressed = std::make_unique_for_overwrite<byte[]>(raw.size());
+        size_t decompressed_size = c->decompress(bytes_view{compressed.get(), compressed_size},
+                                                 std::span<byte>{decompressed.get(), raw.size()});
+        BOOST_CHECK(raw == bytes_view(decompressed.get(), decompressed_size));
+    }
+    return seastar::async([]() {});
+}
+
+SEASTAR_TEST_CASE(compression_offload_round_trip) {
+    return seastar::async([] {
+        bytes raw;
+        for (size_t i = 0; i < 70000; ++i) {
+            raw.push_back(static_cast<byte>(i % 17));
+        }
+        compression_offload offload{{.threshold = 1024, .worker_threads = 2, .max_queued = 2}};
+        auto c = compressor::make(format::CompressionCodec::GZIP);
+        // Both above and below the threshold.
+        for (size_t size : {raw.size(), size_t(100)}) {
+            bytes_view in{raw.data(), size};
+            bytes compressed(c->max_compressed_size(size), 0);
+            size_t compressed_size =
+              offload.compress(*c, in, std::span<byte>{compressed.data(), compressed.size()}).get();
+            compressed.resize(compressed_size);
+            bytes decompressed(size, 0);
+            size_t decompressed_size =
+              offload.decompress(*c, compressed, std::span<byte>{decompressed.data(), decompressed.size()}).get();
+            BOOST_CHECK(in == bytes_view(decompressed.data(), decompressed_size));
+            // Errors are delivered through the future.
+            bytes too_small(size - 1, 0);
+            BOOST_CHECK_THROW(
+              offload.decompress(*c, compressed, std::span<byte>{too_small.data(), too_small.size()}).get(),
+              parquet_exception);
+        }
+        offload.stop().get();
+    });
+}
+
 }  // namespace parquet4seastar::compression
@@ -29,10 +29,9 @@ constexpr parquet4seastar::bytes_view operator""_bv(const char* str, size_t len)
     return {static_cast<const uint8_t*>(static_cast<const void*>(str)), len};
 }
 
-SEASTAR_TEST_CASE(happy) {
+// Prefix lengths {0, 2, 2, 2} and suffixes {"aaaaa", "bbbbbb", "ccccccc", "dddddddd"}.
+parquet4seastar::bytes make_test_data() {
     using namespace parquet4seastar;
-    auto decoder = value_decoder<format::Type::BYTE_ARRAY>({});
-
     bytes suffixes;
     {
         bytes block_size = {0x80, 0x01};    // 128
@@ -84,7 +83,13 @@ SEASTAR_TEST_CASE(happy) {
         lengths = header + block;
     }
 
-    bytes test_data = lengths + suffixes;
+    return lengths + suffixes;
+}
+
+SEASTAR_TEST_CASE(happy) {
+    using namespace parquet4seastar;
+    auto decoder = value_decoder<format::Type::BYTE_ARRAY>({});
+    bytes test_data = make_test_data();
     decoder.reset(test_data, format::Encoding::DELTA_BYTE_ARRAY);
 
     using output_type = decltype(decoder)::output_type;
@@ -111,3 +116,24 @@ SEASTAR_TEST_CASE(happy) {
 
     return seastar::async([]() {});
 }
+
+SEASTAR_TEST_CASE(batches) {
+    using namespace parquet4seastar;
+    auto decoder = value_decoder<format::Type::BYTE_ARRAY>({});
+    bytes test_data = make_test_data();
+
+    // Each value takes its prefix from the previous one, also across batches and skips.
+    for (int page = 0; page < 2; ++page) {
+        decoder.reset(test_data, format::Encoding::DELTA_BYTE_ARRAY);
+        seastar::temporary_buffer<uint8_t> first[1];
+        BOOST_CHECK_EQUAL(decoder.read_batch(1, first), 1);
+        BOOST_CHECK(bytes_view(first[0].get(), first[0].size()) == "aaaaa"_bv);
+        BOOST_CHECK_EQUAL(decoder.skip(1), 1);
+        byte_array_arena<int32_t> rest;
+        BOOST_CHECK_EQUAL(decoder.read_batch(10, rest), 2);
+        BOOST_CHECK(rest[0] == "aabbccccccc"_bv);
+        BOOST_CHECK(rest[1] == "aabbccdddddddd"_bv);
+    }
+
+    return seastar::async([]() {});
+}
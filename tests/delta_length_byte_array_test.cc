@@ -20,6 +20,7 @@
  */
 
 #include <array>
+#include <limits>
 #include <parquet4seastar/encoding.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/testing/test_case.hh>
@@ -79,5 +80,31 @@ SEASTAR_TEST_CASE(happy) {
     BOOST_CHECK_EQUAL(std::size(out), std::size(expected));
     BOOST_CHECK(std::equal(std::begin(out), std::end(out), std::begin(expected), std::end(expected)));
 
+    // The same values, copied into a single buffer at once.
+    decoder.reset(test_data, format::Encoding::DELTA_LENGTH_BYTE_ARRAY);
+    byte_array_arena<int64_t> arena;
+    BOOST_CHECK_EQUAL(decoder.read_batch(3, arena), 3);
+    BOOST_CHECK_EQUAL(decoder.read_batch(3, arena), 1);
+    BOOST_REQUIRE_EQUAL(arena.size(), std::size(strings));
+    BOOST_CHECK(std::equal(std::begin(strings), std::end(strings), arena.offsets().begin(),
+                           [&arena, i = 0](bytes_view s, int64_t) mutable { return arena[i++] == s; }));
+    BOOST_CHECK(bytes_view(arena.data().data(), arena.data().size()) == concatenated_strings);
+
+    return seastar::async([]() {});
+}
+
+// An append which would overflow the offsets throws before it changes the arena.
+SEASTAR_TEST_CASE(arena_overflow) {
+    using namespace parquet4seastar;
+    byte_array_arena<int32_t> arena;
+    arena.push_back("abc"_bv);
+    // 3 + 1 + (2^31 - 4) bytes is one more than 32-bit offsets can address.
+    const int32_t lengths[] = {1, std::numeric_limits<int32_t>::max() - 3};
+    BOOST_CHECK_THROW(arena.append_uninitialized(lengths, std::size(lengths)), parquet_exception);
+    BOOST_REQUIRE_EQUAL(arena.size(), 1);
+    BOOST_CHECK_EQUAL(arena.offsets().size(), 2);
+    BOOST_CHECK_EQUAL(arena.data().size(), 3);
+    arena.push_back("de"_bv);
+    BOOST_CHECK(arena[1] == "de"_bv);
     return seastar::async([]() {});
 }
@@ -0,0 +1,60 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <parquet4seastar/reader_memory.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/testing/test_case.hh>
+
+namespace parquet4seastar {
+
+SEASTAR_TEST_CASE(reader_memory_charges) {
+    return seastar::async([] {
+        reader_memory_limiter limiter{1000};
+        reader_memory_charge a{&limiter};
+        reader_memory_charge b{&limiter};
+
+        a.resize(600).get();
+        BOOST_CHECK_EQUAL(limiter.used(), 600);
+
+        // b has to wait until a shrinks.
+        auto f = b.resize(600);
+        BOOST_CHECK(!f.available());
+        BOOST_CHECK_EQUAL(limiter.waiters(), 1);
+        a.resize(100).get();
+        f.get();
+        BOOST_CHECK_EQUAL(limiter.used(), 700);
+
+        a.release();
+        b.release();
+        BOOST_CHECK_EQUAL(limiter.used(), 0);
+
+        // A request bigger than the whole budget is clamped to it.
+        a.resize(5000).get();
+        BOOST_CHECK_EQUAL(limiter.used(), 1000);
+        a.release();
+
+        // Without a limiter, nothing is charged.
+        reader_memory_charge unlimited;
+        unlimited.resize(5000).get();
+    });
+}
+
+}  // namespace parquet4seastar
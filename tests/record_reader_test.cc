@@ -0,0 +1,156 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+#include <chrono>
+#include <parquet4seastar/file_writer.hh>
+#include <parquet4seastar/record_reader.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/testing/test_case.hh>
+#include <sstream>
+#include <thread>
+
+namespace parquet4seastar {
+
+const std::string test_file_name = "/tmp/parquet4seastar_record_reader_test.parquet";
+
+// Prints records as "id=1 list=[10, 11]", one per line.
+class text_consumer
+{
+    std::ostream& _out;
+    bool _first_column = true;
+    size_t _records = 0;
+
+   public:
+    explicit text_consumer(std::ostream& out) : _out{out} {}
+    void start_record() { _first_column = true; }
+    void end_record() {
+        _out << '\n';
+        // Stall now and then, so that read_all runs past the task quota between buffered records.
+        if (++_records % 1000 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    void start_column(const std::string& name) {
+        if (!_first_column) {
+            _out << ' ';
+        }
+        _first_column = false;
+        _out << name << '=';
+    }
+    void start_struct() { _out << '{'; }
+    void end_struct() { _out << '}'; }
+    void start_field(const std::string& name) { _out << name << ": "; }
+    void start_list() { _out << '['; }
+    void end_list() { _out << ']'; }
+    void start_map() { _out << '{'; }
+    void end_map() { _out << '}'; }
+    void separate_key_value() { _out << ": "; }
+    void separate_list_values() { _out << ", "; }
+    void separate_map_values() { _out << ", "; }
+    void append_null() { _out << "null"; }
+    template <typename LogicalType, typename T>
+    void append_value(LogicalType, const T& v) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            _out << v;
+        } else {
+            _out << '?';
+        }
+    }
+};
+
+// Record i holds a list of i % 5 values, or null if i % 7 == 0. A few records hold several times
+// DEFAULT_BATCH_SIZE values, so that they are longer than the reader's buffers. The others cross
+// batch boundaries wherever they happen to fall.
+size_t list_length(size_t i) {
+    if (i == 700 || i == 701 || i == 5000) {
+        return 3000 + i;
+    }
+    return i % 5;
+}
+
+constexpr size_t n_records = 20000;
+
+// Must be called from a seastar::thread. Returns the expected output of text_consumer.
+std::string write_test_file() {
+    using namespace writer_schema;
+    schema writer_schema;
+    writer_schema.fields.push_back(primitive_node{"id", false, logical_type::INT64{}, {}, format::Encoding::PLAIN,
+                                                  format::CompressionCodec::SNAPPY});
+    writer_schema.fields.push_back(list_node{
+      "list", true,
+      std::make_unique<node>(primitive_node{"element", false, logical_type::INT32{}, {},
+                                            format::Encoding::RLE_DICTIONARY, format::CompressionCodec::SNAPPY})});
+
+    seastar::open_flags flags = seastar::open_flags::wo | seastar::open_flags::create | seastar::open_flags::truncate;
+    auto file = seastar::open_file_dma(test_file_name, flags).get0();
+    auto sink = seastar::make_file_output_stream(file).get0();
+    auto fw = writer<seastar::output_stream<char>>::open(std::move(sink), writer_schema).get0();
+    auto& ids = fw->column<format::Type::INT64>(0);
+    auto& elements = fw->column<format::Type::INT32>(1);
+    std::stringstream expected;
+    for (size_t i = 0; i < n_records; ++i) {
+        ids.put(0, 0, i);
+        expected << "id=" << i << " list=";
+        if (i % 7 == 0) {
+            elements.put(0, 0, 0);
+            expected << "null\n";
+            continue;
+        }
+        size_t length = list_length(i);
+        if (length == 0) {
+            elements.put(1, 0, 0);
+        }
+        expected << '[';
+        for (size_t j = 0; j < length; ++j) {
+            elements.put(2, j == 0 ? 0 : 1, i + j);
+            expected << (j == 0 ? "" : ", ") << i + j;
+        }
+        expected << "]\n";
+        fw->flush_page(1, 4096);
+    }
+    fw->close().get0();
+    return expected.str();
+}
+
+SEASTAR_TEST_CASE(record_reader_long_records) {
+    return seastar::async([] {
+        std::string expected = write_test_file();
+        auto input = seastar::open_file_dma(test_file_name, seastar::open_flags::ro).get0();
+        auto fr = file_reader::open(std::make_unique<SeastarFile>(input)).get0();
+
+        std::stringstream all;
+        text_consumer all_consumer{all};
+        auto rr = record::record_reader::make(fr, 0).get0();
+        rr.read_all(all_consumer).get();
+        BOOST_CHECK(all.str() == expected);
+
+        std::stringstream one;
+        text_consumer one_consumer{one};
+        auto rr2 = record::record_reader::make(fr, 0).get0();
+        for (size_t i = 0; i < n_records; ++i) {
+            rr2.read_one(one_consumer).get();
+        }
+        BOOST_CHECK(one.str() == expected);
+    });
+}
+
+}  // namespace parquet4seastar
@@ -257,3 +257,107 @@ SEASTAR_TEST_CASE(RleDecoder_rle_ULEB128_too_short) {
 
     return seastar::async([]() {});
 }
+
+SEASTAR_TEST_CASE(RleDecoder_skip) {
+    constexpr int bit_width = 3;
+    std::array<uint8_t, 6> packed = {
+      0b00000011, 0b10001000, 0b11000110, 0b11111010,  // bit-packed-run {0, 1, 2, 3, 4, 5, 6, 7}
+      0b00001000, 0b00000101                           // rle-run {5, 5, 5, 5}
+    };
+    std::array<int, 2> unpacked;
+    const std::array<int, 2> expected = {3, 4};
+
+    int values_skipped;
+    int matches = 0;
+    RleDecoder reader(packed.data(), packed.size(), bit_width);
+
+    values_skipped = reader.Skip(3);
+    BOOST_CHECK_EQUAL(values_skipped, 3);
+
+    int values_read = reader.GetBatch(unpacked.data(), unpacked.size());
+    BOOST_CHECK_EQUAL(values_read, expected.size());
+    BOOST_CHECK_EQUAL_COLLECTIONS(unpacked.begin(), unpacked.end(), expected.begin(), expected.end());
+
+    // {5, 6, 7, 5, 5}
+    values_skipped = reader.Skip(5, 5, &matches);
+    BOOST_CHECK_EQUAL(values_skipped, 5);
+    BOOST_CHECK_EQUAL(matches, 3);
+
+    values_skipped = reader.Skip(9999999, 5, &matches);
+    BOOST_CHECK_EQUAL(values_skipped, 2);
+    BOOST_CHECK_EQUAL(matches, 5);
+
+    values_skipped = reader.Skip(9999999);
+    BOOST_CHECK_EQUAL(values_skipped, 0);
+
+    return seastar::async([]() {});
+}
+
+SEASTAR_TEST_CASE(RleDecoder_stats) {
+    constexpr int bit_width = 3;
+    std::array<uint8_t, 6> packed = {
+      0b00000011, 0b10001000, 0b11000110, 0b11111010,  // bit-packed-run {0, 1, 2, 3, 4, 5, 6, 7}
+      0b00001000, 0b00000101                           // rle-run {5, 5, 5, 5}
+    };
+    std::array<uint8_t, 12> unpacked;
+    const std::array<uint8_t, 12> expected = {0, 1, 2, 3, 4, 5, 6, 7, 5, 5, 5, 5};
+
+    uint32_t matches = 0;
+    uint64_t max_value = 0;
+    RleDecoder reader(packed.data(), packed.size(), bit_width);
+
+    int values_read = reader.GetBatchWithStats(unpacked.data(), 6, uint8_t{5}, &matches, &max_value);
+    BOOST_CHECK_EQUAL(values_read, 6);
+    BOOST_CHECK_EQUAL(matches, 1);
+    BOOST_CHECK_EQUAL(max_value, 5);
+
+    values_read = reader.GetBatchWithStats(unpacked.data() + 6, 99, uint8_t{5}, &matches, &max_value);
+    BOOST_CHECK_EQUAL(values_read, 6);
+    BOOST_CHECK_EQUAL_COLLECTIONS(unpacked.begin(), unpacked.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(matches, 5);
+    BOOST_CHECK_EQUAL(max_value, 7);
+
+    // A repeated value which doesn't fit in bit_width bits is reported as is.
+    std::array<uint8_t, 2> corrupted = {0b00001000, 0b11111111};  // rle-run {255, 255, 255, 255}
+    RleDecoder corrupted_reader(corrupted.data(), corrupted.size(), bit_width);
+    max_value = 0;
+    values_read = corrupted_reader.GetBatchWithStats(unpacked.data(), 4, uint8_t{5}, &matches, &max_value);
+    BOOST_CHECK_EQUAL(values_read, 4);
+    BOOST_CHECK_EQUAL(max_value, 255);
+
+    return seastar::async([]() {});
+}
+
+SEASTAR_TEST_CASE(RleDecoder_dict) {
+    constexpr int bit_width = 3;
+    std::array<uint8_t, 6> packed = {
+      0b00000011, 0b10001000, 0b11000110, 0b11111010,  // bit-packed-run {0, 1, 2, 3, 4, 5, 6, 7}
+      0b00001000, 0b00000101                           // rle-run {5, 5, 5, 5}
+    };
+    const std::array<int64_t, 8> dictionary = {10, 11, 12, 13, 14, 15, 16, 17};
+    std::array<int64_t, 12> values;
+    const std::array<int64_t, 12> expected = {10, 11, 12, 13, 14, 15, 16, 17, 15, 15, 15, 15};
+
+    uint64_t max_index = 0;
+    RleDecoder reader(packed.data(), packed.size(), bit_width);
+    int values_read = reader.GetBatchWithDict(dictionary.data(), 8, values.data(), 99, &max_index);
+    BOOST_CHECK_EQUAL(values_read, 12);
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(max_index, 7);
+
+    // Decoding stops before a literal run with an index equal to the dictionary size.
+    RleDecoder short_dict_reader(packed.data(), packed.size(), bit_width);
+    max_index = 0;
+    values_read = short_dict_reader.GetBatchWithDict(dictionary.data(), 7, values.data(), 99, &max_index);
+    BOOST_CHECK_EQUAL(values_read, 0);
+    BOOST_CHECK_EQUAL(max_index, 7);
+
+    // And before a repeated run out of range.
+    RleDecoder repeated_reader(packed.data() + 4, 2, bit_width);
+    max_index = 0;
+    values_read = repeated_reader.GetBatchWithDict(dictionary.data(), 5, values.data(), 99, &max_index);
+    BOOST_CHECK_EQUAL(values_read, 0);
+    BOOST_CHECK_EQUAL(max_index, 5);
+
+    return seastar::async([]() {});
+}
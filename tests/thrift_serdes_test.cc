@@ -21,6 +21,7 @@
 
 #include <parquet4seastar/parquet_types.h>
 
+#include <limits>
 #include <parquet4seastar/thrift_serdes.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/testing/test_case.hh>
@@ -42,3 +43,122 @@ SEASTAR_TEST_CASE(thrift_serdes) {
 
     return seastar::async([]() {});
 }
+
+namespace parquet4seastar {
+
+// A data page header with 2000 bytes of statistics.
+format::PageHeader big_page_header() {
+    format::Statistics stats;
+    stats.__set_max_value(std::string(2000, 'x'));
+    stats.__set_null_count(5);
+    format::DataPageHeader dph;
+    dph.__set_num_values(42);
+    dph.__set_encoding(format::Encoding::RLE_DICTIONARY);
+    dph.__set_definition_level_encoding(format::Encoding::RLE);
+    dph.__set_repetition_level_encoding(format::Encoding::RLE);
+    dph.__set_statistics(stats);
+    format::PageHeader ph;
+    ph.__set_type(format::PageType::DATA_PAGE);
+    ph.__set_uncompressed_page_size(1000);
+    ph.__set_compressed_page_size(900);
+    ph.__set_crc(-7);
+    ph.__set_data_page_header(dph);
+    return ph;
+}
+
+}  // namespace parquet4seastar
+
+SEASTAR_TEST_CASE(page_header) {
+    using namespace parquet4seastar;
+    thrift_serializer serializer;
+
+    format::PageHeader ph = big_page_header();
+    bytes serialized{serializer.serialize(ph)};
+
+    format::PageHeader ph2;
+    auto result = deserialize_page_header(serialized, ph2);
+    BOOST_CHECK_EQUAL(result.size, serialized.size());
+    BOOST_CHECK(ph2 == ph);
+
+    // A truncated header is reported with a lower bound on its full size.
+    for (size_t i = 0; i < serialized.size(); ++i) {
+        result = deserialize_page_header(bytes_view{serialized.data(), i}, ph2);
+        BOOST_CHECK_EQUAL(result.size, 0);
+        BOOST_CHECK_GT(result.min_size, i);
+        BOOST_CHECK_LE(result.min_size, serialized.size());
+    }
+
+    // Fields left over from a previous header must not leak into the next one.
+    format::DictionaryPageHeader dict;
+    dict.__set_num_values(3);
+    dict.__set_encoding(format::Encoding::PLAIN);
+    format::PageHeader dict_ph;
+    dict_ph.__set_type(format::PageType::DICTIONARY_PAGE);
+    dict_ph.__set_uncompressed_page_size(10);
+    dict_ph.__set_compressed_page_size(10);
+    dict_ph.__set_dictionary_page_header(dict);
+    bytes dict_serialized{serializer.serialize(dict_ph)};
+    result = deserialize_page_header(dict_serialized, ph2);
+    BOOST_CHECK_EQUAL(result.size, dict_serialized.size());
+    BOOST_CHECK(ph2 == dict_ph);
+
+    // Only the type field (id 1, i32 zero), followed by the end of the struct.
+    const bytes incomplete = {0x15, 0x00, 0x00};
+    BOOST_CHECK_THROW(deserialize_page_header(incomplete, ph2), parquet_exception);
+
+    // An unknown binary field with a length of 2^64 - 1. The size needed must not wrap around.
+    const bytes huge_length = {0xf8, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+    result = deserialize_page_header(huge_length, ph2);
+    BOOST_CHECK_EQUAL(result.size, 0);
+    BOOST_CHECK_EQUAL(result.min_size, std::numeric_limits<size_t>::max());
+
+    return seastar::async([]() {});
+}
+
+namespace parquet4seastar {
+
+class memory_stream : public IPeekableStream
+{
+    bytes _data;
+    size_t _pos = 0;
+
+   public:
+    explicit memory_stream(bytes data) : _data{std::move(data)} {}
+    seastar::future<bytes_view> peek(size_t n) override {
+        return seastar::make_ready_future<bytes_view>(bytes_view{_data}.substr(_pos, n));
+    }
+    seastar::future<> advance(size_t n) override {
+        if (n > _data.size() - _pos) {
+            throw parquet_exception("Advanced past the end of memory_stream");
+        }
+        _pos += n;
+        return seastar::make_ready_future<>();
+    }
+};
+
+}  // namespace parquet4seastar
+
+// Headers bigger than expected_size are scanned for their size and then parsed from a view of all of them.
+SEASTAR_TEST_CASE(page_header_from_stream) {
+    using namespace parquet4seastar;
+    return seastar::async([] {
+        thrift_serializer serializer;
+        format::PageHeader ph = big_page_header();
+        bytes serialized{serializer.serialize(ph)};
+        for (size_t expected_size : {1, 16, 1024, 4096}) {
+            memory_stream stream{serialized + serialized};
+            format::PageHeader out;
+            for (int i = 0; i < 2; ++i) {
+                BOOST_REQUIRE(read_page_header_from_stream(stream, out, expected_size).get0());
+                BOOST_CHECK(out == ph);
+            }
+            BOOST_CHECK(!read_page_header_from_stream(stream, out, expected_size).get0());
+        }
+
+        format::PageHeader out;
+        memory_stream truncated{bytes{serialized.data(), serialized.size() - 1}};
+        BOOST_CHECK_THROW(read_page_header_from_stream(truncated, out, 16).get(), parquet_exception);
+        memory_stream too_big{serialized};
+        BOOST_CHECK_THROW(read_page_header_from_stream(too_big, out, 16, 1000).get(), parquet_exception);
+    });
+}